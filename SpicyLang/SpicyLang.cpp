@@ -4,6 +4,7 @@
 #include <iostream>
 #include "spicylang/spicyinterpreter.h"
 #include "spicylang/spicycli.h"
+#include "spicylang/spicylog.h"
 
 int main(const int argc, const char* argv[]) {
     const auto spicyLangHeader = []() {
@@ -17,11 +18,20 @@ int main(const int argc, const char* argv[]) {
         std::cout << "--repl\t\trepl loop" << '\n';
         std::cout << "--bytecode\tdump bytecode" << '\n';
         std::cout << "--treewalk\texecute using treewalk interpreter" << '\n';
+        std::cout << "--closures\texecute the ast compiled to closures" << '\n';
         std::cout << "--trace\t\ttrace execution of the bytecode" << '\n';
         std::cout << "--ast\t\tdump ast (treewalk only)" << '\n';
+        std::cout << "--stats\t\tprint compilation stats after running (bytecode only)" << '\n';
+        std::cout << "--emit-prelude	compile the script and print it as the embedded prelude header" << '\n';
+        std::cout << "--log-env\tlog environments being created and switched (debug builds)" << '\n';
+        std::cout << "--log-calls\tlog calls to user functions (debug builds, treewalk and closures)" << '\n';
+        std::cout << "--log-gc\tlog environments being recycled (debug builds)" << '\n';
         std::cout << "--help\t\tdisplay this message" << '\n';
     };
     const auto config = spicy::parseArguments(argc, argv);
+    if (config.log_env) spicy::log::enable(spicy::log::Category::Environment);
+    if (config.log_calls) spicy::log::enable(spicy::log::Category::Call);
+    if (config.log_gc) spicy::log::enable(spicy::log::Category::Gc);
     if (config.is_repl) {
         spicy::SpicyInterpreter interpreter("");
         spicyLangHeader();
@@ -33,12 +43,16 @@ int main(const int argc, const char* argv[]) {
         }
     } else if (!config.help) {
         spicy::SpicyInterpreter interpreter(config.script_path);
-        if (config.treewalk) {
+        if (config.emit_prelude) {
+            interpreter.emitPrelude();
+        } else if (config.treewalk) {
             interpreter.runTreeWalk();
+        } else if (config.closures) {
+            interpreter.runClosures();
         } else if (config.dump_ast) {
             interpreter.dumpAST();
         } else {
-            interpreter.runByteCode();
+            interpreter.runByteCode(config.stats);
         }
     } else {
         usageMessage();
@@ -22,11 +22,6 @@ void spicy::error(Token token, const std::string &msg) {
     }
 }
 
-void spicy::dbgPrint(const std::string &msg) {
-    if (false)
-        std::cout << msg << '\n';
-}
-
 void spicy::runtimeError(const RuntimeError& err) {
     error(err.token(), err.what());
 }
@@ -10,7 +10,6 @@ namespace spicy {
 void error(int line, const std::string& msg);
 void error(Token token, const std::string& msg);
 void report(int line, const std::string& where, const std::string& msg);
-void dbgPrint(const std::string& msg);
 void runtimeError(const RuntimeError& err);
 }
 
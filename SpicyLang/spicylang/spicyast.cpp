@@ -1,5 +1,6 @@
 #include "spicyast.h"
 
+#include <functional>
 #include <initializer_list>
 #include <iterator>
 #include <memory>
@@ -18,8 +19,23 @@ BinaryExpr::BinaryExpr(ExprPtrVariant left, spicy::Token op, ExprPtrVariant righ
 GroupingExpr::GroupingExpr(ExprPtrVariant expression)
     : expression(std::move(expression)) {}
 
-LiteralExpr::LiteralExpr(spicy::OptTokenLiteral value)
-    : literalVal(std::move(value)) {}
+LiteralExpr::LiteralExpr(spicy::OptTokenLiteral literal)
+    : literalVal(std::move(literal)), value(nullptr) {
+  if (!literalVal.has_value()) return;
+  if (std::holds_alternative<double>(literalVal.value())) {
+    value = std::get<double>(literalVal.value());
+    return;
+  }
+  if (std::holds_alternative<int64_t>(literalVal.value())) {
+    value = std::get<int64_t>(literalVal.value());
+    return;
+  }
+  const auto& str = std::get<std::string>(literalVal.value());
+  if (str == "true") value = true;
+  else if (str == "false") value = false;
+  else if (str == "<spicy_list>") isList = true;
+  else if (str != "nil") value = spicy::StringObj::intern(str);
+}
 
 UnaryExpr::UnaryExpr(spicy::Token op, ExprPtrVariant right)
     : op(std::move(op)), right(std::move(right)) {}
@@ -34,10 +50,10 @@ ConditionalExpr::ConditionalExpr(ExprPtrVariant condition,
 PostfixExpr::PostfixExpr(ExprPtrVariant left, spicy::Token op)
     : left(std::move(left)), op(std::move(op)) {}
 
-VariableExpr::VariableExpr(spicy::Token varName) : varName(std::move(varName)) {}
+VariableExpr::VariableExpr(spicy::Token varName, NodeId id) : varName(std::move(varName)), id(id) {}
 
-AssignExpr::AssignExpr(spicy::Token varName, ExprPtrVariant right)
-    : varName(std::move(varName)), right(std::move(right)) {}
+AssignExpr::AssignExpr(spicy::Token varName, ExprPtrVariant right, NodeId id)
+    : varName(std::move(varName)), right(std::move(right)), id(id) {}
 
 LogicalExpr::LogicalExpr(ExprPtrVariant left, spicy::Token op, ExprPtrVariant right)
     : left(std::move(left)), op(std::move(op)), right(std::move(right)) {}
@@ -52,16 +68,22 @@ FuncExpr::FuncExpr(std::vector<spicy::Token> parameters,
                    std::vector<StmtPtrVariant> body)
     : parameters(std::move(parameters)), body(std::move(body)) {}
 
+FieldCache::FieldCache(const std::string& name)
+    : key(std::hash<std::string>{}(name)) {}
+
+PropertyCache::PropertyCache(const std::string& name)
+    : field(name), index(spicy::methodIndex(name)) {}
+
 GetExpr::GetExpr(ExprPtrVariant expr, spicy::Token name)
-    : object(std::move(expr)), name(std::move(name)) {}
+    : object(std::move(expr)), name(std::move(name)), cache(this->name.lexeme) {}
 
 SetExpr::SetExpr(ExprPtrVariant expr, spicy::Token name, ExprPtrVariant value)
-    : object(std::move(expr)), name(std::move(name)), value(std::move(value)) {}
+    : object(std::move(expr)), name(std::move(name)), cache(this->name.lexeme), value(std::move(value)) {}
 
-ThisExpr::ThisExpr(spicy::Token keyword) : keyword(std::move(keyword)) {}
+ThisExpr::ThisExpr(spicy::Token keyword, NodeId id) : keyword(std::move(keyword)), id(id) {}
 
-SuperExpr::SuperExpr(spicy::Token keyword, spicy::Token method)
-    : keyword(std::move(keyword)), method(std::move(method)) {}
+SuperExpr::SuperExpr(spicy::Token keyword, spicy::Token method, NodeId id)
+    : keyword(std::move(keyword)), method(std::move(method)), index(spicy::methodIndex(this->method.lexeme)), id(id) {}
 
 IndexGetExpr::IndexGetExpr(spicy::Token lbracket, ExprPtrVariant arr, ExprPtrVariant idx) 
     : lbracket(std::move(lbracket)), lst(std::move(arr)), idx(std::move(idx)) {}
@@ -99,12 +121,12 @@ auto createPostfixEPV(ExprPtrVariant left, spicy::Token op) -> ExprPtrVariant {
   return std::make_unique<PostfixExpr>(std::move(left), op);
 }
 
-auto createVarEPV(spicy::Token varName) -> ExprPtrVariant {
-  return std::make_unique<VariableExpr>(varName);
+auto createVarEPV(spicy::Token varName, NodeId id) -> ExprPtrVariant {
+  return std::make_unique<VariableExpr>(varName, id);
 }
 
-auto createAssignEPV(spicy::Token varName, ExprPtrVariant expr) -> ExprPtrVariant {
-  return std::make_unique<AssignExpr>(varName, std::move(expr));
+auto createAssignEPV(spicy::Token varName, ExprPtrVariant expr, NodeId id) -> ExprPtrVariant {
+  return std::make_unique<AssignExpr>(varName, std::move(expr), id);
 }
 
 auto createLogicalEPV(ExprPtrVariant left, spicy::Token op, ExprPtrVariant right)
@@ -133,12 +155,12 @@ auto createSetEPV(ExprPtrVariant expr, spicy::Token name, ExprPtrVariant value)
                                    std::move(value));
 }
 
-auto createThisEPV(spicy::Token keyword) -> ExprPtrVariant {
-  return std::make_unique<ThisExpr>(std::move(keyword));
+auto createThisEPV(spicy::Token keyword, NodeId id) -> ExprPtrVariant {
+  return std::make_unique<ThisExpr>(std::move(keyword), id);
 }
 
-auto createSuperEPV(spicy::Token keyword, spicy::Token method) -> ExprPtrVariant {
-  return std::make_unique<SuperExpr>(std::move(keyword), std::move(method));
+auto createSuperEPV(spicy::Token keyword, spicy::Token method, NodeId id) -> ExprPtrVariant {
+  return std::make_unique<SuperExpr>(std::move(keyword), std::move(method), id);
 }
 
 auto createIndexGetEPV(spicy::Token lbracket, ExprPtrVariant arr, ExprPtrVariant idx) -> ExprPtrVariant {
@@ -2,6 +2,7 @@
 #ifndef H_SPICYAST
 #define H_SPICYAST
 
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <variant>
@@ -12,6 +13,10 @@
 
 namespace spicy::ast {
 
+// The parser numbers the expressions that name a variable, from 0 up, so that whatever is learned about them
+// (see ResolvedLocals) can be kept in flat tables instead of being looked up by node address.
+using NodeId = uint32_t;
+
 // Expression types forward-declaration
 struct BinaryExpr;
 struct GroupingExpr;
@@ -93,15 +98,15 @@ auto createGroupingEPV(ExprPtrVariant right) -> ExprPtrVariant;
 auto createLiteralEPV(spicy::OptTokenLiteral literal) -> ExprPtrVariant;
 auto createConditionalEPV(ExprPtrVariant condition, ExprPtrVariant then, ExprPtrVariant elseBranch) -> ExprPtrVariant;
 auto createPostfixEPV(ExprPtrVariant left, spicy::Token op) -> ExprPtrVariant;
-auto createVarEPV(spicy::Token varName) -> ExprPtrVariant;
-auto createAssignEPV(spicy::Token varName, ExprPtrVariant expr) -> ExprPtrVariant;
+auto createVarEPV(spicy::Token varName, NodeId id) -> ExprPtrVariant;
+auto createAssignEPV(spicy::Token varName, ExprPtrVariant expr, NodeId id) -> ExprPtrVariant;
 auto createLogicalEPV(ExprPtrVariant left, spicy::Token op, ExprPtrVariant right) -> ExprPtrVariant;
 auto createCallEPV(ExprPtrVariant callee, spicy::Token paren, std::vector<ExprPtrVariant> arguments) -> ExprPtrVariant;
 auto createFuncEPV(std::vector<spicy::Token> params, std::vector<StmtPtrVariant> fnBody) -> ExprPtrVariant;
 auto createGetEPV(ExprPtrVariant expr, spicy::Token name) -> ExprPtrVariant;
 auto createSetEPV(ExprPtrVariant expr, spicy::Token name, ExprPtrVariant value) -> ExprPtrVariant;
-auto createThisEPV(spicy::Token keyword) -> ExprPtrVariant;
-auto createSuperEPV(spicy::Token keyword, spicy::Token method) -> ExprPtrVariant;
+auto createThisEPV(spicy::Token keyword, NodeId id) -> ExprPtrVariant;
+auto createSuperEPV(spicy::Token keyword, spicy::Token method, NodeId id) -> ExprPtrVariant;
 auto createIndexGetEPV(spicy::Token lbracket, ExprPtrVariant arr, ExprPtrVariant idx) -> ExprPtrVariant;
 auto createIndexSetEPV(spicy::Token lbracket, ExprPtrVariant arr, ExprPtrVariant idx, ExprPtrVariant val) -> ExprPtrVariant;
 
@@ -131,6 +136,8 @@ struct GroupingExpr final : public util::Uncopyable {
 
 struct LiteralExpr final : public util::Uncopyable {
   spicy::OptTokenLiteral literalVal;
+  spicy::SpicyObj value;  // what literalVal evaluates to, worked out once when the node is made
+  bool isList = false;    // list literals evaluate to a new list every time, value stays nil for them
   explicit LiteralExpr(spicy::OptTokenLiteral value);
 };
 
@@ -156,13 +163,15 @@ struct PostfixExpr final : public util::Uncopyable {
 
 struct VariableExpr final : public util::Uncopyable {
   spicy::Token varName;
-  explicit VariableExpr(spicy::Token varName);
+  NodeId id;
+  VariableExpr(spicy::Token varName, NodeId id);
 };
 
 struct AssignExpr final : public util::Uncopyable {
   spicy::Token varName;
   ExprPtrVariant right;
-  AssignExpr(spicy::Token varName, ExprPtrVariant right);
+  NodeId id;
+  AssignExpr(spicy::Token varName, ExprPtrVariant right, NodeId id);
 };
 
 struct LogicalExpr final : public util::Uncopyable {
@@ -186,28 +195,56 @@ struct FuncExpr final : public util::Uncopyable {
   FuncExpr(std::vector<spicy::Token> parameters, std::vector<StmtPtrVariant> body);
 };
 
+// Inline cache of a field access, kept on its node. The name is hashed once, and the slot it was last found at is
+// remembered with the shape of the instance it was on: every instance of that shape has the field at the same slot.
+// Shapes are never freed, the pointer can't dangle.
+struct FieldCache {
+  size_t key;                                // hashed name
+  const spicy::Shape* shape = nullptr;
+  std::optional<uint32_t> slot;              // nullopt if the shape has no such field
+  const spicy::Shape* grown = nullptr;       // assignments only: the shape once the missing field is added
+  explicit FieldCache(const std::string& name);
+};
+
+// Inline cache of a property access, kept on its node. Fields shadow methods, they're looked up first through
+// their own cache. The method the name last resolved to is remembered with the receiver's class: classes don't
+// change once made, so the entry holds for as long as the receivers are of that class.
+// The class is only known by its id, not held: the ast can outlive everything the evaluator made.
+struct PropertyCache {
+  FieldCache field;
+  spicy::MethodIndex index;
+  uint64_t classId = 0;   // ids start at 1
+  const spicy::SpicyObj* method = nullptr;   // owned by the class, nullptr if the name isn't a method
+  explicit PropertyCache(const std::string& name);
+};
+
 struct GetExpr final : public util::Uncopyable {
   ExprPtrVariant object;
   spicy::Token name;
+  PropertyCache cache;
   GetExpr(ExprPtrVariant expr, spicy::Token name);
 };
 
 struct SetExpr final : public util::Uncopyable {
   ExprPtrVariant object;
   spicy::Token name;
+  FieldCache cache;
   ExprPtrVariant value;
   SetExpr(ExprPtrVariant expr, spicy::Token name, ExprPtrVariant value);
 };
 
 struct ThisExpr final : public util::Uncopyable {
   spicy::Token keyword;
-  explicit ThisExpr(spicy::Token keyword);
+  NodeId id;
+  ThisExpr(spicy::Token keyword, NodeId id);
 };
 
 struct SuperExpr final : public util::Uncopyable {
   spicy::Token keyword;
   spicy::Token method;
-  explicit SuperExpr(spicy::Token keyword, spicy::Token method);
+  spicy::MethodIndex index;
+  NodeId id;
+  SuperExpr(spicy::Token keyword, spicy::Token method, NodeId id);
 };
 
 struct IndexGetExpr final : public util::Uncopyable {
@@ -238,6 +275,8 @@ struct PrintStmt final : public util::Uncopyable {
 
 struct BlockStmt final : public util::Uncopyable {
   std::vector<StmtPtrVariant> statements;
+  // cleared by the resolver when the block declares nothing, it then runs in the enclosing scope
+  bool hasScope = true;
   explicit BlockStmt(std::vector<StmtPtrVariant> statements);
 };
 
@@ -270,6 +309,8 @@ struct FuncStmt : public util::Uncopyable {
 struct RetStmt : public util::Uncopyable {
   spicy::Token ret;
   std::optional<ExprPtrVariant> value;
+  // set by the resolver when a function returns a call's result as is, the call can then reuse the frame
+  bool isTailCall = false;
   RetStmt(spicy::Token ret, std::optional<ExprPtrVariant> value);
 };
 
@@ -21,6 +21,11 @@ struct LiteralPrintVisitor {
         return "\"" + stringLiteral + "\"";
     }
     
+    [[nodiscard]]
+    std::string operator()(const int64_t& numLiteral) {
+        return std::to_string(numLiteral);
+    }
+
     [[nodiscard]]
     std::string operator()(const double& numLiteral) {
         auto result = std::to_string(numLiteral);
@@ -1,18 +1,22 @@
 #include "spicybuiltins.h"
 
+#include <algorithm>
 #include <variant>
 #include <chrono>
+#include <cmath>
+
+#include "spicykernels.h"
 
 namespace spicy {
 
 // ======================= clock ==========================
 ClockBuiltIn::ClockBuiltIn() : BuiltinFunc("clock") {}
 
-size_t ClockBuiltIn::arity() {
+size_t ClockBuiltIn::arity() const {
     return 0;
 }
 
-SpicyObj ClockBuiltIn::run() {
+SpicyObj ClockBuiltIn::run(std::span<const SpicyObj>) const {
     const std::chrono::time_point<std::chrono::system_clock> now =
             std::chrono::system_clock::now();
     return static_cast<double>(now.time_since_epoch().count());
@@ -21,96 +25,335 @@ SpicyObj ClockBuiltIn::run() {
 // ======================== str ===========================
 StrBuiltIn::StrBuiltIn() : BuiltinFunc("str") {}
 
-size_t StrBuiltIn::arity() {
+size_t StrBuiltIn::arity() const {
     return 1;
 }
 
-SpicyObj StrBuiltIn::run() {
-    auto value = m_args[0];
-    m_args.clear();
-    return getObjString(value);
+SpicyObj StrBuiltIn::run(std::span<const SpicyObj> args) const {
+    // strings are immutable, it can be handed back as is
+    if (args[0].is<std::string>())
+        return args[0];
+    return getObjString(args[0]);
 }
 
 // ======================= sqrt ===========================
 SqrtBuiltIn::SqrtBuiltIn()
     : BuiltinFunc("sqrt") {}
 
-size_t SqrtBuiltIn::arity() {
+size_t SqrtBuiltIn::arity() const {
     return 1;
 }
 
-SpicyObj SqrtBuiltIn::run() {
-    auto& val = m_args[0];
-    if (!std::holds_alternative<double>(val))
+SpicyObj SqrtBuiltIn::run(std::span<const SpicyObj> args) const {
+    const auto& val = args[0];
+    if (!numbers::isNumber(val))
         return nullptr;
-    auto valDbl = std::get<double>(val);
-    m_args.clear();
-    return std::sqrt(valDbl);
+    return std::sqrt(numbers::toDouble(val));
 }
 
 // ======================== len ===========================
 LenBuiltIn::LenBuiltIn()
     : BuiltinFunc("len") {}
 
-size_t LenBuiltIn::arity() {
+size_t LenBuiltIn::arity() const {
     return 1;
 }
 
-SpicyObj LenBuiltIn::run() {
-    auto& val = m_args[0];
-    SpicyObj ret;
-	if (std::holds_alternative<SpicyListSharedPtr>(val)) {
-        ret = std::get<SpicyListSharedPtr>(val)->size();
-    } else if (std::holds_alternative<std::string>(val)) {
-        ret = static_cast<double>(std::get<std::string>(val).length());
-    } else {
-        ret = nullptr;
+SpicyObj LenBuiltIn::run(std::span<const SpicyObj> args) const {
+    const auto& val = args[0];
+    if (val.is<SpicyListSharedPtr>()) {
+        return val.as<SpicyListSharedPtr>()->size();
+    } else if (val.is<std::string>()) {
+        return static_cast<int64_t>(val.as<StringSharedPtr>()->length());
     }
-    m_args.clear();
-    return ret;
+    return nullptr;
 }
 
 // ======================= front ==========================
 FrontBuiltIn::FrontBuiltIn()
     : BuiltinFunc("front") {}
 
-size_t FrontBuiltIn::arity() {
+size_t FrontBuiltIn::arity() const {
     return 1;
 }
 
-SpicyObj FrontBuiltIn::run() {
-    auto& val = m_args[0];
-    SpicyObj ret;
-    if (std::holds_alternative<SpicyListSharedPtr>(val)) {
-        ret = std::get<SpicyListSharedPtr>(val)->front();
-    } else if (std::holds_alternative<std::string>(val)) {
-        ret = std::string{ std::get<std::string>(val).front() };
-    } else {
-        ret = nullptr;
+SpicyObj FrontBuiltIn::run(std::span<const SpicyObj> args) const {
+    const auto& val = args[0];
+    if (val.is<SpicyListSharedPtr>()) {
+        return val.as<SpicyListSharedPtr>()->front();
+    } else if (val.is<std::string>() && !val.as<std::string>().empty()) {
+        return std::string{ val.as<std::string>().front() };
     }
-    m_args.clear();
-    return ret;
+    return nullptr;
 }
 
 // ======================= back ===========================
 BackBuiltIn::BackBuiltIn()
-    : BuiltinFunc("front") {}
+    : BuiltinFunc("back") {}
+
+size_t BackBuiltIn::arity() const {
+    return 1;
+}
+
+SpicyObj BackBuiltIn::run(std::span<const SpicyObj> args) const {
+    const auto& val = args[0];
+    if (val.is<SpicyListSharedPtr>()) {
+        return val.as<SpicyListSharedPtr>()->back();
+    } else if (val.is<std::string>() && !val.as<std::string>().empty()) {
+        return std::string{ val.as<std::string>().back() };
+    }
+    return nullptr;
+}
+
+// ================== numeric list helpers ================
+namespace {
+
+// the elements of a list of integers, nullopt if the value is anything else
+std::optional<std::span<const int64_t>> integers(const SpicyObj& val) {
+    if (!val.is<SpicyListSharedPtr>()) return std::nullopt;
+    const auto* items = std::get_if<util::GapVector<int64_t>>(&val.as<SpicyListSharedPtr>()->storage());
+    if (items == nullptr) return std::nullopt;
+    return items->span();
+}
+
+// The elements of a list of numbers as doubles, nullopt if the value isn't one. Lists of doubles are read in place,
+// the others are converted into scratch.
+std::optional<std::span<const double>> doubles(const SpicyObj& val, std::vector<double>& scratch) {
+    if (!val.is<SpicyListSharedPtr>()) return std::nullopt;
+    return std::visit([&](const auto& items) -> std::optional<std::span<const double>> {
+        using T = typename std::decay_t<decltype(items)>::value_type;
+        if constexpr (std::is_same_v<T, double>) {
+            return items.span();
+        } else if constexpr (std::is_same_v<T, bool>) {
+            return std::nullopt;
+        } else {
+            scratch.reserve(items.size());
+            for (auto i = size_t{0}; i < items.size(); ++i) {
+                if constexpr (std::is_same_v<T, int64_t>) {
+                    scratch.push_back(static_cast<double>(items[i]));
+                } else {
+                    if (!numbers::isNumber(items[i])) return std::nullopt;
+                    scratch.push_back(numbers::toDouble(items[i]));
+                }
+            }
+            return std::span<const double>(scratch);
+        }
+    }, val.as<SpicyListSharedPtr>()->storage());
+}
+
+template <typename T>
+SpicyObj makeList(std::vector<T> items) {
+    return makeRef<SpicyList>(util::GapVector<T>(std::move(items)));
+}
+
+// The integer versions of the kernels, done in plain loops since they have to check every step for overflow.
+// nullopt as soon as a result doesn't fit, the doubles take over then.
+std::optional<int64_t> sumIntegers(std::span<const int64_t> xs) {
+    auto total = int64_t{0};
+    for (const auto x : xs) {
+        const auto next = numbers::checkedAdd(total, x);
+        if (!next) return std::nullopt;
+        total = *next;
+    }
+    return total;
+}
+
+std::optional<int64_t> dotIntegers(std::span<const int64_t> xs, std::span<const int64_t> ys) {
+    auto total = int64_t{0};
+    for (auto i = size_t{0}; i < xs.size(); ++i) {
+        const auto product = numbers::checkedMultiply(xs[i], ys[i]);
+        const auto next = product ? numbers::checkedAdd(total, *product) : std::nullopt;
+        if (!next) return std::nullopt;
+        total = *next;
+    }
+    return total;
+}
+
+// a * xs[i] + ys[i], without the ys when there are none
+std::optional<std::vector<int64_t>> axpyIntegers(int64_t a, std::span<const int64_t> xs,
+                                                 std::optional<std::span<const int64_t>> ys) {
+    auto out = std::vector<int64_t>(xs.size());
+    for (auto i = size_t{0}; i < xs.size(); ++i) {
+        auto value = numbers::checkedMultiply(a, xs[i]);
+        if (value && ys) value = numbers::checkedAdd(*value, (*ys)[i]);
+        if (!value) return std::nullopt;
+        out[i] = *value;
+    }
+    return out;
+}
+
+} // namespace
+
+// ======================= sum ============================
+SumBuiltIn::SumBuiltIn()
+    : BuiltinFunc("sum") {}
 
-size_t BackBuiltIn::arity() {
+size_t SumBuiltIn::arity() const {
     return 1;
 }
 
-SpicyObj BackBuiltIn::run() {
-    auto& val = m_args[0];
-    SpicyObj ret;
-    if (std::holds_alternative<SpicyListSharedPtr>(val)) {
-        ret = std::get<SpicyListSharedPtr>(val)->back();
-    } else if (std::holds_alternative<std::string>(val)) {
-        ret = std::string{ std::get<std::string>(val).back() };
-    } else {
-        ret = nullptr;
+SpicyObj SumBuiltIn::run(std::span<const SpicyObj> args) const {
+    if (const auto xs = integers(args[0])) {
+        if (const auto total = sumIntegers(*xs)) return *total;
     }
-    m_args.clear();
-    return ret;
+    auto scratch = std::vector<double>{};
+    const auto xs = doubles(args[0], scratch);
+    if (!xs) return nullptr;
+    if (xs->empty()) return int64_t{0};
+    return kernels::sum(*xs);
 }
+
+// ======================= dot ============================
+DotBuiltIn::DotBuiltIn()
+    : BuiltinFunc("dot") {}
+
+size_t DotBuiltIn::arity() const {
+    return 2;
+}
+
+SpicyObj DotBuiltIn::run(std::span<const SpicyObj> args) const {
+    const auto xInts = integers(args[0]);
+    const auto yInts = integers(args[1]);
+    if (xInts && yInts && xInts->size() == yInts->size()) {
+        if (const auto total = dotIntegers(*xInts, *yInts)) return *total;
+    }
+    auto xScratch = std::vector<double>{};
+    auto yScratch = std::vector<double>{};
+    const auto xs = doubles(args[0], xScratch);
+    const auto ys = doubles(args[1], yScratch);
+    if (!xs || !ys || xs->size() != ys->size()) return nullptr;
+    if (xs->empty()) return int64_t{0};
+    return kernels::dot(*xs, *ys);
+}
+
+// ======================= min ============================
+MinBuiltIn::MinBuiltIn()
+    : BuiltinFunc("min") {}
+
+size_t MinBuiltIn::arity() const {
+    return 1;
+}
+
+SpicyObj MinBuiltIn::run(std::span<const SpicyObj> args) const {
+    if (const auto xs = integers(args[0]); xs && !xs->empty()) {
+        return *std::ranges::min_element(*xs);
+    }
+    auto scratch = std::vector<double>{};
+    const auto xs = doubles(args[0], scratch);
+    if (!xs || xs->empty()) return nullptr;
+    return kernels::min(*xs);
+}
+
+// ======================= max ============================
+MaxBuiltIn::MaxBuiltIn()
+    : BuiltinFunc("max") {}
+
+size_t MaxBuiltIn::arity() const {
+    return 1;
+}
+
+SpicyObj MaxBuiltIn::run(std::span<const SpicyObj> args) const {
+    if (const auto xs = integers(args[0]); xs && !xs->empty()) {
+        return *std::ranges::max_element(*xs);
+    }
+    auto scratch = std::vector<double>{};
+    const auto xs = doubles(args[0], scratch);
+    if (!xs || xs->empty()) return nullptr;
+    return kernels::max(*xs);
+}
+
+// ====================== scale ===========================
+ScaleBuiltIn::ScaleBuiltIn()
+    : BuiltinFunc("scale") {}
+
+size_t ScaleBuiltIn::arity() const {
+    return 2;
+}
+
+// scale(list, factor)
+SpicyObj ScaleBuiltIn::run(std::span<const SpicyObj> args) const {
+    const auto& factor = args[1];
+    if (!numbers::isNumber(factor)) return nullptr;
+    if (const auto xs = integers(args[0]); xs && factor.is<int64_t>()) {
+        if (auto out = axpyIntegers(factor.as<int64_t>(), *xs, std::nullopt)) return makeList(std::move(*out));
+    }
+    auto scratch = std::vector<double>{};
+    const auto xs = doubles(args[0], scratch);
+    if (!xs) return nullptr;
+    auto out = std::vector<double>(xs->size());
+    kernels::scale(numbers::toDouble(factor), *xs, out);
+    return makeList(std::move(out));
+}
+
+// ======================= add ============================
+AddBuiltIn::AddBuiltIn()
+    : BuiltinFunc("add") {}
+
+size_t AddBuiltIn::arity() const {
+    return 2;
+}
+
+SpicyObj AddBuiltIn::run(std::span<const SpicyObj> args) const {
+    const auto xInts = integers(args[0]);
+    const auto yInts = integers(args[1]);
+    if (xInts && yInts && xInts->size() == yInts->size()) {
+        if (auto out = axpyIntegers(1, *xInts, yInts)) return makeList(std::move(*out));
+    }
+    auto xScratch = std::vector<double>{};
+    auto yScratch = std::vector<double>{};
+    const auto xs = doubles(args[0], xScratch);
+    const auto ys = doubles(args[1], yScratch);
+    if (!xs || !ys || xs->size() != ys->size()) return nullptr;
+    auto out = std::vector<double>(xs->size());
+    kernels::add(*xs, *ys, out);
+    return makeList(std::move(out));
+}
+
+// ======================= axpy ===========================
+AxpyBuiltIn::AxpyBuiltIn()
+    : BuiltinFunc("axpy") {}
+
+size_t AxpyBuiltIn::arity() const {
+    return 3;
+}
+
+// axpy(a, xs, ys), a new list holding a * xs + ys
+SpicyObj AxpyBuiltIn::run(std::span<const SpicyObj> args) const {
+    const auto& factor = args[0];
+    if (!numbers::isNumber(factor)) return nullptr;
+    const auto xInts = integers(args[1]);
+    const auto yInts = integers(args[2]);
+    if (factor.is<int64_t>() && xInts && yInts && xInts->size() == yInts->size()) {
+        if (auto out = axpyIntegers(factor.as<int64_t>(), *xInts, yInts)) return makeList(std::move(*out));
+    }
+    auto xScratch = std::vector<double>{};
+    auto yScratch = std::vector<double>{};
+    const auto xs = doubles(args[1], xScratch);
+    const auto ys = doubles(args[2], yScratch);
+    if (!xs || !ys || xs->size() != ys->size()) return nullptr;
+    auto out = std::vector<double>(xs->size());
+    kernels::axpy(numbers::toDouble(factor), *xs, *ys, out);
+    return makeList(std::move(out));
+}
+
+// ====================== registry ========================
+auto getBuiltins() -> const std::vector<BuiltinFuncSharedPtr>& {
+    static const auto builtins = std::vector<BuiltinFuncSharedPtr>{
+        makeRef<ClockBuiltIn>(),
+        makeRef<StrBuiltIn>(),
+        makeRef<SqrtBuiltIn>(),
+        makeRef<LenBuiltIn>(),
+        makeRef<FrontBuiltIn>(),
+        makeRef<BackBuiltIn>(),
+        makeRef<SumBuiltIn>(),
+        makeRef<DotBuiltIn>(),
+        makeRef<MinBuiltIn>(),
+        makeRef<MaxBuiltIn>(),
+        makeRef<ScaleBuiltIn>(),
+        makeRef<AddBuiltIn>(),
+        makeRef<AxpyBuiltIn>(),
+    };
+    return builtins;
+}
+
 } // namespace spicy
@@ -2,6 +2,8 @@
 #ifndef SPICY_SPICYBUILTINS_H
 #define SPICY_SPICYBUILTINS_H
 
+#include <vector>
+
 #include "spicyobjects.h"
 
 namespace spicy {
@@ -10,50 +12,113 @@ class ClockBuiltIn : public BuiltinFunc {
 public:
     ClockBuiltIn();
 
-    size_t arity() override;
-    SpicyObj run() override;
+    size_t arity() const override;
+    SpicyObj run(std::span<const SpicyObj> args) const override;
 };
 
 class StrBuiltIn : public BuiltinFunc {
 public:
     StrBuiltIn();
 
-    size_t arity() override;
-    SpicyObj run() override;
+    size_t arity() const override;
+    SpicyObj run(std::span<const SpicyObj> args) const override;
 };
 
 class SqrtBuiltIn : public BuiltinFunc {
 public:
     SqrtBuiltIn();
 
-    size_t arity() override;
-    SpicyObj run() override;
+    size_t arity() const override;
+    SpicyObj run(std::span<const SpicyObj> args) const override;
 };
 
 class LenBuiltIn : public BuiltinFunc {
 public:
     LenBuiltIn();
     
-    size_t arity() override;
-    SpicyObj run() override;
+    size_t arity() const override;
+    SpicyObj run(std::span<const SpicyObj> args) const override;
 };
 
 class FrontBuiltIn : public BuiltinFunc {
 public:
     FrontBuiltIn();
     
-    size_t arity() override;
-    SpicyObj run() override;
+    size_t arity() const override;
+    SpicyObj run(std::span<const SpicyObj> args) const override;
 };
 
 class BackBuiltIn : public BuiltinFunc {
 public:
     BackBuiltIn();
     
-    size_t arity() override;
-    SpicyObj run() override;
+    size_t arity() const override;
+    SpicyObj run(std::span<const SpicyObj> args) const override;
+};
+
+// Numeric list builtins, they run on native loops over the elements (see spicykernels.h) instead of interpreting one
+// step per element. Lists of integers stay exact as long as the results fit, anything else is computed in doubles.
+// Lists that aren't all numbers, or of different lengths, give nil.
+class SumBuiltIn : public BuiltinFunc {
+public:
+    SumBuiltIn();
+
+    size_t arity() const override;
+    SpicyObj run(std::span<const SpicyObj> args) const override;
+};
+
+class DotBuiltIn : public BuiltinFunc {
+public:
+    DotBuiltIn();
+
+    size_t arity() const override;
+    SpicyObj run(std::span<const SpicyObj> args) const override;
+};
+
+class MinBuiltIn : public BuiltinFunc {
+public:
+    MinBuiltIn();
+
+    size_t arity() const override;
+    SpicyObj run(std::span<const SpicyObj> args) const override;
+};
+
+class MaxBuiltIn : public BuiltinFunc {
+public:
+    MaxBuiltIn();
+
+    size_t arity() const override;
+    SpicyObj run(std::span<const SpicyObj> args) const override;
+};
+
+class ScaleBuiltIn : public BuiltinFunc {
+public:
+    ScaleBuiltIn();
+
+    size_t arity() const override;
+    SpicyObj run(std::span<const SpicyObj> args) const override;
 };
 
+class AddBuiltIn : public BuiltinFunc {
+public:
+    AddBuiltIn();
+
+    size_t arity() const override;
+    SpicyObj run(std::span<const SpicyObj> args) const override;
+};
+
+class AxpyBuiltIn : public BuiltinFunc {
+public:
+    AxpyBuiltIn();
+
+    size_t arity() const override;
+    SpicyObj run(std::span<const SpicyObj> args) const override;
+};
+
+// every builtin, shared by the tree-walker and the vm since they don't hold any state
+[[nodiscard]]
+auto getBuiltins() -> const std::vector<BuiltinFuncSharedPtr>&;
+
 } // namespace spicy
 
 #endif // SPICY_SPICYBUILTINS_H
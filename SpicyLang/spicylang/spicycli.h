@@ -14,7 +14,13 @@ struct SpicyConfig {
     bool dump_ast = false;
     bool help = false;
     bool treewalk = false;
+    bool closures = false;
     bool trace = false;
+    bool stats = false;
+    bool emit_prelude = false;
+    bool log_env = false;
+    bool log_calls = false;
+    bool log_gc = false;
     std::string script_path = "";
     
     friend SpicyConfig operator+(const SpicyConfig& lhs, const SpicyConfig& rhs) {
@@ -24,7 +30,13 @@ struct SpicyConfig {
             .dump_ast = lhs.dump_ast || rhs.dump_ast,
             .help = lhs.help || rhs.help,
             .treewalk = lhs.treewalk || rhs.treewalk,
+            .closures = lhs.closures || rhs.closures,
             .trace = lhs.trace || rhs.trace,
+            .stats = lhs.stats || rhs.stats,
+            .emit_prelude = lhs.emit_prelude || rhs.emit_prelude,
+            .log_env = lhs.log_env || rhs.log_env,
+            .log_calls = lhs.log_calls || rhs.log_calls,
+            .log_gc = lhs.log_gc || rhs.log_gc,
             .script_path = rhs.script_path
         };
     }
@@ -47,7 +59,13 @@ namespace parsers {
                 | match_flag("bytecode", &SpicyConfig::dump_bytecode)
                 | match_flag("help", &SpicyConfig::help)
                 | match_flag("treewalk", &SpicyConfig::treewalk)
+                | match_flag("closures", &SpicyConfig::closures)
                 | match_flag("trace", &SpicyConfig::trace)
+                | match_flag("stats", &SpicyConfig::stats)
+                | match_flag("emit-prelude", &SpicyConfig::emit_prelude)
+                | match_flag("log-env", &SpicyConfig::log_env)
+                | match_flag("log-calls", &SpicyConfig::log_calls)
+                | match_flag("log-gc", &SpicyConfig::log_gc)
                 | match_flag("ast", &SpicyConfig::dump_ast);
     }
     
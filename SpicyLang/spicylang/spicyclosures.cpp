@@ -0,0 +1,656 @@
+#include "spicyclosures.h"
+
+#include <format>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <variant>
+
+#include "spicy.h"
+#include "spicybuiltins.h"
+#include "spicyeval.h"
+#include "spicylog.h"
+
+namespace spicy::eval {
+
+namespace {
+
+// where a variable lives, picked once at translation so every access goes straight to its slot or its name
+struct LocalRef {
+    EnvironmentMgr* envMgr;
+    uint32_t distance;
+    uint32_t slot;
+    [[nodiscard]] SpicyObj get() const { return envMgr->get(distance, slot); }
+    void set(SpicyObj value) const { envMgr->assignAt(distance, slot, std::move(value)); }
+};
+
+struct GlobalRef {
+    EnvironmentMgr* envMgr;
+    Token name;
+    [[nodiscard]] SpicyObj get() const { return envMgr->getGlobal(name); }
+    void set(SpicyObj value) const { envMgr->assignGlobal(name, std::move(value)); }
+};
+
+template <auto Op>
+ExprClosure numericBinary(ExprClosure left, ExprClosure right, Token op) {
+    return [left = std::move(left), right = std::move(right), op = std::move(op)]() -> SpicyObj {
+        const auto lval = left();
+        const auto rval = right();
+        typecheck::checkBinaryNumOperands(op, lval, rval);
+        return Op(lval, rval);
+    };
+}
+
+ExprClosure throwing(Token token, std::string msg) {
+    return [token = std::move(token), msg = std::move(msg)]() -> SpicyObj {
+        throw RuntimeError(token, msg);
+    };
+}
+
+} // namespace
+
+SpicyClosureEvaluator::SpicyClosureEvaluator(const ResolvedLocals& locals)
+    : m_locals(locals) {
+    for (const auto& builtin : getBuiltins()) {
+        m_envMgr.defineGlobal(builtin->getFuncName(), builtin);
+    }
+}
+
+StmtClosure SpicyClosureEvaluator::compile(const std::vector<ast::StmtPtrVariant>& stmts) {
+    return compileStmts(stmts);
+}
+
+// ===============================================================================================================================
+// EXPRESSIONS
+// ===============================================================================================================================
+
+struct ClosureExprCompiler {
+    SpicyClosureEvaluator* const eval;
+    explicit ClosureExprCompiler(SpicyClosureEvaluator* eval) : eval(eval) {}
+    ExprClosure operator()(const ast::BinaryExprPtr& expr) { return eval->compileBinaryExpr(expr); }
+    ExprClosure operator()(const ast::GroupingExprPtr& expr) { return eval->compileGroupingExpr(expr); }
+    ExprClosure operator()(const ast::LiteralExprPtr& expr) { return eval->compileLiteralExpr(expr); }
+    ExprClosure operator()(const ast::UnaryExprPtr& expr) { return eval->compileUnaryExpr(expr); }
+    ExprClosure operator()(const ast::ConditionalExprPtr& expr) { return [] { return SpicyObj{nullptr}; }; }
+    ExprClosure operator()(const ast::PostfixExprPtr& expr) { return eval->compilePostfixExpr(expr); }
+    ExprClosure operator()(const ast::VariableExprPtr& expr) { return eval->compileVariableExpr(expr); }
+    ExprClosure operator()(const ast::AssignExprPtr& expr) { return eval->compileAssignExpr(expr); }
+    ExprClosure operator()(const ast::LogicalExprPtr& expr) { return eval->compileLogicalExpr(expr); }
+    ExprClosure operator()(const ast::CallExprPtr& expr) { return eval->compileCallExpr(expr); }
+    ExprClosure operator()(const ast::FuncExprPtr& expr) { return eval->compileFuncExpr(expr); }
+    ExprClosure operator()(const ast::GetExprPtr& expr) { return eval->compileGetExpr(expr); }
+    ExprClosure operator()(const ast::SetExprPtr& expr) { return eval->compileSetExpr(expr); }
+    ExprClosure operator()(const ast::ThisExprPtr& expr) { return eval->compileThisExpr(expr); }
+    ExprClosure operator()(const ast::SuperExprPtr& expr) { return eval->compileSuperExpr(expr); }
+    ExprClosure operator()(const ast::IndexGetExprPtr& expr) { return eval->compileIndexGetExpr(expr); }
+    ExprClosure operator()(const ast::IndexSetExprPtr& expr) { return eval->compileIndexSetExpr(expr); }
+};
+
+ExprClosure SpicyClosureEvaluator::compileExpr(const ast::ExprPtrVariant& expr) {
+    return std::visit(ClosureExprCompiler(this), expr);
+}
+
+template <typename MakeClosure>
+ExprClosure SpicyClosureEvaluator::withVariable(ast::NodeId id, const Token& name, MakeClosure&& makeClosure) {
+    if (const auto local = m_locals.find(id); local.has_value()) {
+        return makeClosure(LocalRef{ .envMgr = &m_envMgr, .distance = local->distance, .slot = local->slot });
+    }
+    return makeClosure(GlobalRef{ .envMgr = &m_envMgr, .name = name });
+}
+
+ExprClosure SpicyClosureEvaluator::compileLiteralExpr(const ast::LiteralExprPtr& expr) {
+    if (expr->isList) {
+        return [] { return SpicyObj{makeRef<SpicyList>()}; };
+    }
+    return [obj = expr->value] { return obj; };
+}
+
+ExprClosure SpicyClosureEvaluator::compileGroupingExpr(const ast::GroupingExprPtr& expr) {
+    return compileExpr(expr->expression);
+}
+
+ExprClosure SpicyClosureEvaluator::compileUnaryExpr(const ast::UnaryExprPtr& expr) {
+    auto right = compileExpr(expr->right);
+    switch (expr->op.type) {
+    case TokenType::MINUS:
+        return [right = std::move(right), op = expr->op]() -> SpicyObj {
+            const auto rval = right();
+            typecheck::checkUnaryNumOperand(op, rval);
+            return numbers::negate(rval);
+        };
+    case TokenType::BANG:
+        return [right = std::move(right)]() -> SpicyObj {
+            return !isTrue(right());
+        };
+    case TokenType::PLUS_PLUS:
+    case TokenType::MINUS_MINUS: {
+        if (!std::holds_alternative<ast::VariableExprPtr>(expr->right)) {
+            return [right = std::move(right), op = expr->op]() -> SpicyObj {
+                std::ignore = right();
+                throw RuntimeError(op, "Operand must be a variable.");
+            };
+        }
+        const auto& varExpr = std::get<ast::VariableExprPtr>(expr->right);
+        const auto delta = int64_t{expr->op.type == TokenType::PLUS_PLUS ? 1 : -1};
+        return withVariable(varExpr->id, varExpr->varName, [&](auto ref) -> ExprClosure {
+            return [ref, right = std::move(right), op = expr->op, delta]() -> SpicyObj {
+                const auto rval = right();
+                typecheck::checkUnaryNumOperand(op, rval);
+                const auto value = numbers::add(rval, delta);
+                ref.set(value);
+                return value;
+            };
+        });
+    }
+    default:
+        return [right = std::move(right), op = expr->op]() -> SpicyObj {
+            std::ignore = right();
+            throw RuntimeError(op, "Invalid unary operator.");
+        };
+    }
+}
+
+ExprClosure SpicyClosureEvaluator::compilePostfixExpr(const ast::PostfixExprPtr& expr) {
+    if (!std::holds_alternative<ast::VariableExprPtr>(expr->left))
+        return throwing(expr->op, "Operand must be a variable.");
+    if (!(expr->op.type == TokenType::PLUS_PLUS || expr->op.type == TokenType::MINUS_MINUS))
+        return throwing(expr->op, "Invalid postfix operator.");
+    const auto& varExpr = std::get<ast::VariableExprPtr>(expr->left);
+    const auto delta = int64_t{expr->op.type == TokenType::PLUS_PLUS ? 1 : -1};
+    return withVariable(varExpr->id, varExpr->varName, [&](auto ref) -> ExprClosure {
+        return [ref, op = expr->op, delta]() -> SpicyObj {
+            const SpicyObj lval = ref.get();
+            typecheck::checkUnaryNumOperand(op, lval);
+            ref.set(numbers::add(lval, delta));
+            return lval;
+        };
+    });
+}
+
+ExprClosure SpicyClosureEvaluator::compileBinaryExpr(const ast::BinaryExprPtr& expr) {
+    auto left = compileExpr(expr->left);
+    auto right = compileExpr(expr->right);
+    const auto& op = expr->op;
+    switch (op.type) {
+    case TokenType::PLUS:
+        return [left = std::move(left), right = std::move(right), op]() -> SpicyObj {
+            const auto lval = left();
+            const auto rval = right();
+            typecheck::checkPlusOperands(op, lval, rval);
+            return internal::evalPlusBinOp(lval, rval);
+        };
+    case TokenType::MINUS:         return numericBinary<numbers::subtract>(std::move(left), std::move(right), op);
+    case TokenType::SLASH:         return numericBinary<numbers::divide>(std::move(left), std::move(right), op);
+    case TokenType::STAR:          return numericBinary<numbers::multiply>(std::move(left), std::move(right), op);
+    case TokenType::GREATER:       return numericBinary<numbers::compare<std::greater<>>>(std::move(left), std::move(right), op);
+    case TokenType::GREATER_EQUAL: return numericBinary<numbers::compare<std::greater_equal<>>>(std::move(left), std::move(right), op);
+    case TokenType::LESS:          return numericBinary<numbers::compare<std::less<>>>(std::move(left), std::move(right), op);
+    case TokenType::LESS_EQUAL:    return numericBinary<numbers::compare<std::less_equal<>>>(std::move(left), std::move(right), op);
+    case TokenType::BANG_EQUAL:
+        return [left = std::move(left), right = std::move(right)]() -> SpicyObj {
+            const auto lval = left();
+            return !areEqual(lval, right());
+        };
+    case TokenType::EQUAL_EQUAL:
+        return [left = std::move(left), right = std::move(right)]() -> SpicyObj {
+            const auto lval = left();
+            return areEqual(lval, right());
+        };
+    case TokenType::ARROW:
+        return [left = std::move(left), right = std::move(right), op]() -> SpicyObj {
+            const auto lval = left();
+            const auto rval = right();
+            typecheck::checkAppendOperands(op, lval, rval);
+            auto lst = lval.as<SpicyListSharedPtr>();
+            lst->append(op, rval);
+            return lst;
+        };
+    case TokenType::RARROW:
+        return [left = std::move(left), right = std::move(right), op]() -> SpicyObj {
+            const auto lval = left();
+            const auto rval = right();
+            typecheck::checkAppendOperands(op, lval, rval);
+            auto lst = rval.as<SpicyListSharedPtr>();
+            lst->appendFront(op, lval);
+            return lst;
+        };
+    default:
+        // the operands still run first, like they do in the tree-walker
+        return [left = std::move(left), right = std::move(right), op]() -> SpicyObj {
+            std::ignore = left();
+            std::ignore = right();
+            throw RuntimeError(op, "Unexpected operator in binary expression.");
+        };
+    }
+}
+
+ExprClosure SpicyClosureEvaluator::compileVariableExpr(const ast::VariableExprPtr& expr) {
+    return withVariable(expr->id, expr->varName, [](auto ref) -> ExprClosure {
+        return [ref] { return ref.get(); };
+    });
+}
+
+ExprClosure SpicyClosureEvaluator::compileAssignExpr(const ast::AssignExprPtr& expr) {
+    auto right = compileExpr(expr->right);
+    return withVariable(expr->id, expr->varName, [&](auto ref) -> ExprClosure {
+        return [ref, right = std::move(right)] {
+            auto value = right();
+            ref.set(value);
+            return value;
+        };
+    });
+}
+
+ExprClosure SpicyClosureEvaluator::compileLogicalExpr(const ast::LogicalExprPtr& expr) {
+    auto left = compileExpr(expr->left);
+    auto right = compileExpr(expr->right);
+    if (expr->op.type == TokenType::OR) {
+        return [left = std::move(left), right = std::move(right)] {
+            auto lhs = left();
+            return isTrue(lhs) ? lhs : right();
+        };
+    }
+    return [left = std::move(left), right = std::move(right)] {
+        auto lhs = left();
+        return !isTrue(lhs) ? lhs : right();
+    };
+}
+
+ExprClosure SpicyClosureEvaluator::compileCallExpr(const ast::CallExprPtr& expr) {
+    auto callee = compileCallee(expr->callee);
+    auto args = std::vector<ExprClosure>{};
+    args.reserve(expr->arguments.size());
+    for (const auto& arg : expr->arguments) {
+        args.emplace_back(compileExpr(arg));
+    }
+    return [this, callee = std::move(callee), args = std::move(args), paren = expr->paren] {
+        auto [calleeObj, receiver] = callee();
+        return call(calleeObj, std::move(receiver), args, paren);
+    };
+}
+
+// obj.method() never binds the method, the instance it was found on is handed to the call as its receiver instead
+CalleeClosure SpicyClosureEvaluator::compileCallee(const ast::ExprPtrVariant& expr) {
+    if (!std::holds_alternative<ast::GetExprPtr>(expr)) {
+        return [callee = compileExpr(expr)] { return Callee{ callee(), nullptr }; };
+    }
+    const auto& get = std::get<ast::GetExprPtr>(expr);
+    return [object = compileExpr(get->object), name = get->name, cache = ast::PropertyCache(get->name.lexeme)]() mutable {
+        auto obj = object();
+        if (!obj.is<SpicyInstanceSharedPtr>()) {
+            throw RuntimeError(name, "Only class instances have properties.");
+        }
+        auto instance = obj.as<SpicyInstanceSharedPtr>();
+        if (const auto* field = instance->findField(cache.field))
+            return Callee{ *field, nullptr };
+        return Callee{ instance->getMethod(name, cache), std::move(instance) };
+    };
+}
+
+ExprClosure SpicyClosureEvaluator::compileGetExpr(const ast::GetExprPtr& expr) {
+    // each closure keeps its own inline cache
+    return [object = compileExpr(expr->object), name = expr->name, cache = ast::PropertyCache(expr->name.lexeme)]() mutable -> SpicyObj {
+        const auto obj = object();
+        if (!obj.is<SpicyInstanceSharedPtr>()) {
+            throw RuntimeError(name, "Only class instances have properties.");
+        }
+        const auto instance = obj.as<SpicyInstanceSharedPtr>();
+        if (const auto* field = instance->findField(cache.field))
+            return *field;
+        // a method taken as a value remembers the instance it came from
+        return instance->getMethod(name, cache).as<FuncSharedPtr>()->bind(instance);
+    };
+}
+
+ExprClosure SpicyClosureEvaluator::compileSetExpr(const ast::SetExprPtr& expr) {
+    return [object = compileExpr(expr->object), value = compileExpr(expr->value), name = expr->name, cache = ast::FieldCache(expr->name.lexeme)]() mutable {
+        const auto obj = object();
+        if (!obj.is<SpicyInstanceSharedPtr>()) {
+            throw RuntimeError(name, "Only instances have fields.");
+        }
+        auto val = value();
+        obj.as<SpicyInstanceSharedPtr>()->set(cache, val);
+        return val;
+    };
+}
+
+ExprClosure SpicyClosureEvaluator::compileThisExpr(const ast::ThisExprPtr& expr) {
+    return withVariable(expr->id, expr->keyword, [](auto ref) -> ExprClosure {
+        return [ref] { return ref.get(); };
+    });
+}
+
+ExprClosure SpicyClosureEvaluator::compileSuperExpr(const ast::SuperExprPtr& expr) {
+    // "super" is alone in the scope enclosing the methods, "this" comes first in the method's own frame
+    const auto distance = m_locals.find(expr->id).value().distance;
+    return [this, distance, method = expr->method, index = expr->index]() -> SpicyObj {
+        const auto superClass = m_envMgr.get(distance, 0).as<SpicyClassSharedPtr>();
+        const auto instance = m_envMgr.get(distance - 1, 0).as<SpicyInstanceSharedPtr>();
+        const auto* found = superClass->lookupMethod(index);
+        if (found == nullptr)
+            throw RuntimeError(method, std::format("Attempted to access undefined property {} on super.", method.lexeme));
+        return found->as<FuncSharedPtr>()->bind(instance);
+    };
+}
+
+ExprClosure SpicyClosureEvaluator::compileFuncExpr(const ast::FuncExprPtr& expr) {
+    return [this, decl = &expr, body = compileFunction(expr)]() -> SpicyObj {
+        auto func = makeRef<FuncObj>(*decl, "___lambda", m_envMgr.getCurrentEnvironment());
+        func->setCompiledBody(body);
+        return func;
+    };
+}
+
+ExprClosure SpicyClosureEvaluator::compileIndexGetExpr(const ast::IndexGetExprPtr& expr) {
+    return [lst = compileExpr(expr->lst), idx = compileExpr(expr->idx), lbracket = expr->lbracket] {
+        const auto lstObj = lst();
+        if (!lstObj.is<SpicyListSharedPtr>())
+            throw RuntimeError(lbracket, "Can only perform indexing operations on lists.");
+        const auto idxObj = idx();
+        if (!numbers::isNumber(idxObj))
+            throw RuntimeError(lbracket, "Index expression must evaluate to a number.");
+        return lstObj.as<SpicyListSharedPtr>()->get(lbracket, static_cast<int>(numbers::toInteger(idxObj)));
+    };
+}
+
+ExprClosure SpicyClosureEvaluator::compileIndexSetExpr(const ast::IndexSetExprPtr& expr) {
+    return [lst = compileExpr(expr->lst), idx = compileExpr(expr->idx), val = compileExpr(expr->val),
+            lbracket = expr->lbracket] {
+        const auto lstObj = lst();
+        if (!lstObj.is<SpicyListSharedPtr>())
+            throw RuntimeError(lbracket, "Can only perform indexing operations on lists.");
+        const auto idxObj = idx();
+        if (!numbers::isNumber(idxObj))
+            throw RuntimeError(lbracket, "Index expression must evaluate to a number.");
+        lstObj.as<SpicyListSharedPtr>()->set(lbracket, static_cast<int>(numbers::toInteger(idxObj)), val());
+        return lstObj;
+    };
+}
+
+// ===============================================================================================================================
+// STATEMENTS
+// ===============================================================================================================================
+
+struct ClosureStmtCompiler {
+    SpicyClosureEvaluator* const eval;
+    explicit ClosureStmtCompiler(SpicyClosureEvaluator* eval) : eval(eval) {}
+    StmtClosure operator()(const ast::ExprStmtPtr& stmt) { return eval->compileExpressionStmt(stmt); }
+    StmtClosure operator()(const ast::PrintStmtPtr& stmt) { return eval->compilePrintStmt(stmt); }
+    StmtClosure operator()(const ast::BlockStmtPtr& stmt) { return eval->compileBlockStmt(stmt); }
+    StmtClosure operator()(const ast::VarStmtPtr& stmt) { return eval->compileVarStmt(stmt); }
+    StmtClosure operator()(const ast::IfStmtPtr& stmt) { return eval->compileIfStmt(stmt); }
+    StmtClosure operator()(const ast::WhileStmtPtr& stmt) { return eval->compileWhileStmt(stmt); }
+    StmtClosure operator()(const ast::FuncStmtPtr& stmt) { return eval->compileFuncStmt(stmt); }
+    StmtClosure operator()(const ast::RetStmtPtr& stmt) { return eval->compileRetStmt(stmt); }
+    StmtClosure operator()(const ast::ClassStmtPtr& stmt) { return eval->compileClassStmt(stmt); }
+};
+
+StmtClosure SpicyClosureEvaluator::compileStmt(const ast::StmtPtrVariant& stmt) {
+    return std::visit(ClosureStmtCompiler(this), stmt);
+}
+
+// same contract as SpicyEvaluator::execStmts: stop at the first return or value, report runtime errors here
+StmtClosure SpicyClosureEvaluator::compileStmts(const std::vector<ast::StmtPtrVariant>& stmts) {
+    auto closures = std::vector<StmtClosure>{};
+    for (const auto& stmt : stmts) {
+        closures.emplace_back(compileStmt(stmt));
+        // nothing after a return ever runs
+        if (std::holds_alternative<ast::RetStmtPtr>(stmt)) break;
+    }
+    return [closures = std::move(closures)] {
+        OptSpicyObj result = std::nullopt;
+        try {
+            for (const auto& closure : closures) {
+                result = closure();
+                if (result.has_value()) break;
+            }
+        } catch (const RuntimeError& err) {
+            runtimeError(err);
+        }
+        return result;
+    };
+}
+
+StmtClosure SpicyClosureEvaluator::compileExpressionStmt(const ast::ExprStmtPtr& stmt) {
+    return [expression = compileExpr(stmt->expression)]() -> OptSpicyObj {
+        std::ignore = expression();
+        return std::nullopt;
+    };
+}
+
+StmtClosure SpicyClosureEvaluator::compilePrintStmt(const ast::PrintStmtPtr& stmt) {
+    return [expression = compileExpr(stmt->expression)]() -> OptSpicyObj {
+        std::cout << expression() << '\n';
+        return std::nullopt;
+    };
+}
+
+StmtClosure SpicyClosureEvaluator::compileBlockStmt(const ast::BlockStmtPtr& stmt) {
+    if (!stmt->hasScope)
+        return compileStmts(stmt->statements);
+    m_scopeDepth++;
+    auto stmts = compileStmts(stmt->statements);
+    m_scopeDepth--;
+    return [this, stmts = std::move(stmts)] {
+        const auto prevEnv = m_envMgr.getCurrentEnvironment();
+        m_envMgr.createNewEnvironment("execBlockStmt");
+        auto result = stmts();
+        m_envMgr.setCurrentEnvironment(prevEnv, "execBlockStmt");
+        return result;
+    };
+}
+
+StmtClosure SpicyClosureEvaluator::compileVarStmt(const ast::VarStmtPtr& stmt) {
+    auto initializer = stmt->initializer.has_value()
+        ? compileExpr(stmt->initializer.value())
+        : ExprClosure{ [] { return SpicyObj{nullptr}; } };
+    if (m_scopeDepth > 0) {
+        return [this, initializer = std::move(initializer)]() -> OptSpicyObj {
+            m_envMgr.defineLocal(initializer());
+            return std::nullopt;
+        };
+    }
+    return [this, initializer = std::move(initializer), name = stmt->varName.lexeme]() -> OptSpicyObj {
+        m_envMgr.defineGlobal(name, initializer());
+        return std::nullopt;
+    };
+}
+
+StmtClosure SpicyClosureEvaluator::compileIfStmt(const ast::IfStmtPtr& stmt) {
+    auto condition = compileExpr(stmt->condition);
+    auto thenBranch = compileStmt(stmt->thenBranch);
+    if (!stmt->elseBranch.has_value()) {
+        return [condition = std::move(condition), thenBranch = std::move(thenBranch)]() -> OptSpicyObj {
+            if (isTrue(condition())) return thenBranch();
+            return std::nullopt;
+        };
+    }
+    return [condition = std::move(condition), thenBranch = std::move(thenBranch),
+            elseBranch = compileStmt(stmt->elseBranch.value())] {
+        return isTrue(condition()) ? thenBranch() : elseBranch();
+    };
+}
+
+StmtClosure SpicyClosureEvaluator::compileWhileStmt(const ast::WhileStmtPtr& stmt) {
+    return [condition = compileExpr(stmt->condition), body = compileStmt(stmt->loopBody)] {
+        OptSpicyObj result = std::nullopt;
+        while (!result.has_value() && isTrue(condition())) {
+            result = body();
+        }
+        return result;
+    };
+}
+
+StmtClosure SpicyClosureEvaluator::compileFuncStmt(const ast::FuncStmtPtr& stmt) {
+    return [this, decl = &stmt->funcExpr, name = stmt->funcName, body = compileFunction(stmt->funcExpr),
+            isLocal = m_scopeDepth > 0]() -> OptSpicyObj {
+        auto func = makeRef<FuncObj>(*decl, name.lexeme, m_envMgr.getCurrentEnvironment());
+        func->setCompiledBody(body);
+        define(name, std::move(func), isLocal);
+        return std::nullopt;
+    };
+}
+
+StmtClosure SpicyClosureEvaluator::compileRetStmt(const ast::RetStmtPtr& stmt) {
+    if (!stmt->value.has_value()) {
+        return [] { return OptSpicyObj{}; };
+    }
+    if (stmt->isTailCall) {
+        const auto& expr = std::get<ast::CallExprPtr>(stmt->value.value());
+        auto args = std::vector<ExprClosure>{};
+        args.reserve(expr->arguments.size());
+        for (const auto& arg : expr->arguments) {
+            args.emplace_back(compileExpr(arg));
+        }
+        return [this, callee = compileCallee(expr->callee), args = std::move(args), paren = expr->paren]() -> OptSpicyObj {
+            auto [calleeObj, receiver] = callee();
+            if (!calleeObj.is<FuncSharedPtr>())
+                return call(calleeObj, std::move(receiver), args, paren);
+            // left for the trampoline in callFunction, nil only stands in for the result, same as the tree-walker
+            const auto func = calleeObj.as<FuncSharedPtr>();
+            m_tailCall = TailCall{ func, newFrame(func, std::move(receiver), args, paren) };
+            return SpicyObj{nullptr};
+        };
+    }
+    return [value = compileExpr(stmt->value.value())] {
+        return std::make_optional(value());
+    };
+}
+
+StmtClosure SpicyClosureEvaluator::compileClassStmt(const ast::ClassStmtPtr& stmt) {
+    const auto hasSuperClass = stmt->superClass.has_value();
+    auto superClass = hasSuperClass ? compileExpr(stmt->superClass.value()) : ExprClosure{};
+
+    struct Method {
+        const ast::FuncStmtPtr* decl;
+        std::shared_ptr<const CompiledBody> body;
+    };
+    // methods sit below the "super" scope if there's one
+    const auto isLocal = m_scopeDepth > 0;
+    m_scopeDepth += hasSuperClass ? 1 : 0;
+    auto methods = std::vector<Method>{};
+    for (const auto& method : stmt->methods) {
+        methods.emplace_back(Method{ .decl = &method, .body = compileFunction(method->funcExpr) });
+    }
+    m_scopeDepth -= hasSuperClass ? 1 : 0;
+
+    return [this, name = stmt->className, superClass = std::move(superClass), methods = std::move(methods),
+            isLocal]() -> OptSpicyObj {
+        auto superClassObj = std::optional<SpicyClassSharedPtr>{};
+        if (superClass) {
+            auto obj = superClass();
+            if (!obj.is<SpicyClassSharedPtr>())
+                throw RuntimeError(name, "Superclass must be a class; cannot inherit from a non-class.");
+            superClassObj = obj.as<SpicyClassSharedPtr>();
+            m_envMgr.createNewEnvironment("execClassStmt");
+            m_envMgr.defineLocal(superClassObj.value());
+        }
+
+        auto methodObjs = std::vector<std::pair<std::string, SpicyObj>>{};
+        for (const auto& [decl, body] : methods) {
+            const auto& methodName = (*decl)->funcName.lexeme;
+            auto func = makeRef<FuncObj>((*decl)->funcExpr, methodName, m_envMgr.getCurrentEnvironment(),
+                                                  true, methodName == "init");
+            func->setCompiledBody(body);
+            methodObjs.emplace_back(methodName, std::move(func));
+        }
+        auto class_ = makeRef<SpicyClass>(name.lexeme, std::move(superClassObj), std::move(methodObjs));
+
+        if (superClass)
+            m_envMgr.setCurrentEnvironment(m_envMgr.getCurrentEnvironment()->getParent(), "execClassStmt");
+
+        define(name, std::move(class_), isLocal);
+        return std::nullopt;
+    };
+}
+
+// ===============================================================================================================================
+// FUNCTIONS
+// ===============================================================================================================================
+
+std::shared_ptr<const CompiledBody> SpicyClosureEvaluator::compileFunction(const ast::FuncExprPtr& decl) {
+    m_scopeDepth++;
+    auto body = std::make_shared<CompiledBody>(CompiledBody{ .stmts = compileStmts(decl->body) });
+    m_scopeDepth--;
+    return body;
+}
+
+void SpicyClosureEvaluator::define(const Token& name, SpicyObj value, bool isLocal) {
+    if (isLocal)
+        m_envMgr.defineLocal(std::move(value));
+    else
+        m_envMgr.defineGlobal(name.lexeme, std::move(value));
+}
+
+SpicyObj SpicyClosureEvaluator::call(const SpicyObj& callee, SpicyInstanceSharedPtr receiver,
+                                     const std::vector<ExprClosure>& args, const Token& paren) {
+    if (callee.is<BuiltinFuncSharedPtr>()) {
+        const auto builtin = callee.as<BuiltinFuncSharedPtr>();
+        if (builtin->arity() != args.size())
+            throw RuntimeError(paren, std::format("Expected {} args but got {}.", builtin->arity(), args.size()));
+        auto values = std::vector<SpicyObj>{};
+        values.reserve(args.size());
+        for (const auto& arg : args)
+            values.emplace_back(arg());
+        return builtin->run(values);
+    }
+
+    if (callee.is<SpicyClassSharedPtr>()) {
+        const auto class_ = callee.as<SpicyClassSharedPtr>();
+        auto instance = makeRef<SpicyInstance>(class_);
+        static const auto initIndex = methodIndex("init");
+        if (const auto* init = class_->lookupMethod(initIndex))
+            call(*init, instance, args, paren);
+        else if (!args.empty())
+            throw RuntimeError(paren, std::format("Expected 0 argurments but got {}.", args.size()));
+        return instance;
+    }
+
+    if (!callee.is<FuncSharedPtr>())
+        throw RuntimeError(paren, "Attempted to invoke a non-function.");
+    const auto func = callee.as<FuncSharedPtr>();
+
+    auto ret = callFunction(func, newFrame(func, std::move(receiver), args, paren));
+    return ret.has_value() ? ret.value() : SpicyObj{nullptr};
+}
+
+Environment::EnvironmentPtr SpicyClosureEvaluator::newFrame(const FuncSharedPtr& func, SpicyInstanceSharedPtr receiver,
+                                                            const std::vector<ExprClosure>& args, const Token& paren) {
+    if (args.size() != func->arity())
+        throw RuntimeError(paren, std::format("Expected {} argurments but got {}.", func->arity(), args.size()));
+
+    // the arguments are evaluated in the caller's environment, straight into the parameter slots of the new one,
+    // behind the receiver for methods
+    auto frame = m_envMgr.newEnvironment(func->getClosure(), func->getFuncName());
+    if (func->isMethod())
+        frame->define(receiver != nullptr ? std::move(receiver) : func->getReceiver());
+    for (const auto& arg : args)
+        frame->define(arg());
+
+    SPICY_LOG(log::Category::Call, "[line {}] calling {} with {} args", paren.line, func->getFuncName(), args.size());
+    return frame;
+}
+
+OptSpicyObj SpicyClosureEvaluator::callFunction(const FuncSharedPtr& func, Environment::EnvironmentPtr frame) {
+    auto prevEnv = m_envMgr.getCurrentEnvironment();
+    auto ret = OptSpicyObj{};
+    // calls returned from tail position come back here instead of nesting
+    for (auto next = TailCall{ func, std::move(frame) };;) {
+        const auto* current = next.frame.get();
+        m_envMgr.setCurrentEnvironment(std::move(next.frame), next.func->getFuncName());
+        ret = next.func->getCompiledBody()->stmts();
+
+        // initializers give back their receiver, the first slot of their frame
+        if (next.func->isInit())
+            ret = current->get(0);
+
+        if (!m_tailCall.has_value()) break;
+        next = std::move(m_tailCall.value());
+        m_tailCall.reset();
+    }
+
+    m_envMgr.setCurrentEnvironment(std::move(prevEnv), func->getFuncName());
+    return ret;
+}
+
+} // namespace spicy::eval
@@ -0,0 +1,104 @@
+#pragma once
+#ifndef H_SPICYCLOSURES
+#define H_SPICYCLOSURES
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "spicyast.h"
+#include "spicyenvironment.h"
+#include "spicyobjects.h"
+#include "spicyresolver.h"
+
+namespace spicy::eval {
+
+using ExprClosure = std::function<SpicyObj()>;
+using StmtClosure = std::function<OptSpicyObj()>;
+
+// what a call expression calls, and the instance it's called on when that's a method looked up in place
+struct Callee {
+    SpicyObj value;
+    SpicyInstanceSharedPtr receiver;
+};
+using CalleeClosure = std::function<Callee()>;
+
+// a translated function body, shared by every FuncObj made from the same declaration
+struct CompiledBody {
+    StmtClosure stmts;
+};
+
+/*
+ * Closure-compiled execution, an alternative to SpicyEvaluator with the same semantics.
+ * The resolved program is translated once into a tree of closures, each specialized for its operator or for
+ * where its variable lives (slot of a local, name of a global), so running it is just calling the root closure:
+ * no variant dispatch and no operator switch left per evaluation.
+ * The closures point back at the evaluator for its environments, it has to outlive them.
+ */
+class SpicyClosureEvaluator {
+    // a call made from tail position, waiting for the trampoline in callFunction to run it
+    struct TailCall {
+        FuncSharedPtr func;
+        Environment::EnvironmentPtr frame;
+    };
+
+    EnvironmentMgr m_envMgr{};
+    const ResolvedLocals& m_locals;
+    uint32_t m_scopeDepth = 0;
+    std::optional<TailCall> m_tailCall;
+
+public:
+    explicit SpicyClosureEvaluator(const ResolvedLocals& locals);
+
+    [[nodiscard]] StmtClosure compile(const std::vector<ast::StmtPtrVariant>& stmts);
+
+private:
+    ExprClosure compileExpr(const ast::ExprPtrVariant& expr);
+    ExprClosure compileLiteralExpr(const ast::LiteralExprPtr& expr);
+    ExprClosure compileGroupingExpr(const ast::GroupingExprPtr& expr);
+    ExprClosure compileUnaryExpr(const ast::UnaryExprPtr& expr);
+    ExprClosure compilePostfixExpr(const ast::PostfixExprPtr& expr);
+    ExprClosure compileBinaryExpr(const ast::BinaryExprPtr& expr);
+    ExprClosure compileVariableExpr(const ast::VariableExprPtr& expr);
+    ExprClosure compileAssignExpr(const ast::AssignExprPtr& expr);
+    ExprClosure compileLogicalExpr(const ast::LogicalExprPtr& expr);
+    ExprClosure compileCallExpr(const ast::CallExprPtr& expr);
+    CalleeClosure compileCallee(const ast::ExprPtrVariant& expr);
+    ExprClosure compileGetExpr(const ast::GetExprPtr& expr);
+    ExprClosure compileSetExpr(const ast::SetExprPtr& expr);
+    ExprClosure compileThisExpr(const ast::ThisExprPtr& expr);
+    ExprClosure compileSuperExpr(const ast::SuperExprPtr& expr);
+    ExprClosure compileFuncExpr(const ast::FuncExprPtr& expr);
+    ExprClosure compileIndexGetExpr(const ast::IndexGetExprPtr& expr);
+    ExprClosure compileIndexSetExpr(const ast::IndexSetExprPtr& expr);
+
+    StmtClosure compileStmt(const ast::StmtPtrVariant& stmt);
+    StmtClosure compileStmts(const std::vector<ast::StmtPtrVariant>& stmts);
+    StmtClosure compileExpressionStmt(const ast::ExprStmtPtr& stmt);
+    StmtClosure compilePrintStmt(const ast::PrintStmtPtr& stmt);
+    StmtClosure compileBlockStmt(const ast::BlockStmtPtr& stmt);
+    StmtClosure compileVarStmt(const ast::VarStmtPtr& stmt);
+    StmtClosure compileIfStmt(const ast::IfStmtPtr& stmt);
+    StmtClosure compileWhileStmt(const ast::WhileStmtPtr& stmt);
+    StmtClosure compileFuncStmt(const ast::FuncStmtPtr& stmt);
+    StmtClosure compileRetStmt(const ast::RetStmtPtr& stmt);
+    StmtClosure compileClassStmt(const ast::ClassStmtPtr& stmt);
+
+    std::shared_ptr<const CompiledBody> compileFunction(const ast::FuncExprPtr& decl);
+    template <typename MakeClosure>
+    ExprClosure withVariable(ast::NodeId id, const Token& name, MakeClosure&& makeClosure);
+    void define(const Token& name, SpicyObj value, bool isLocal);
+
+    SpicyObj call(const SpicyObj& callee, SpicyInstanceSharedPtr receiver, const std::vector<ExprClosure>& args, const Token& paren);
+    Environment::EnvironmentPtr newFrame(const FuncSharedPtr& func, SpicyInstanceSharedPtr receiver,
+                                         const std::vector<ExprClosure>& args, const Token& paren);
+    OptSpicyObj callFunction(const FuncSharedPtr& func, Environment::EnvironmentPtr frame);
+
+    friend struct ClosureExprCompiler;
+    friend struct ClosureStmtCompiler;
+};
+
+} // namespace spicy::eval
+
+#endif // H_SPICYCLOSURES
@@ -1,568 +1,737 @@
 #include "spicycompiler.h"
 
+#include <algorithm>
 #include <format>
+#include <limits>
 #include <variant>
 
+#include "spicy.h"
+
 namespace spicy {
 
-SpicyCompiler::SpicyCompiler(SpicyScanner scanner) : m_scanner(std::move(scanner)) {
-    /*
-     * This monstrosity is all the rules for our Pratt parser
-     */
-    m_rules[TokenType::ARROW]          = { std::nullopt,                       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::RARROW]    = { std::nullopt,                       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::LEFT_PAREN]      = { [&](bool) { this->grouping(); },    std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::RIGHT_PAREN]     = { std::nullopt,                       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::LEFT_BRACE]      = { std::nullopt,                       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::RIGHT_BRACE]     = { std::nullopt,                       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::COMMA]           = { std::nullopt,                       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::DOT]             = { std::nullopt,                       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::MINUS]           = { [&](bool) { this->unary(); },       [&](bool) { this->binary(); },  Precedence::PREC_TERM };
-    m_rules[TokenType::PLUS]            = { std::nullopt,                       [&](bool) { this->binary(); },  Precedence::PREC_TERM };
-    m_rules[TokenType::SEMICOLON]       = { std::nullopt,                       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::SLASH]           = { std::nullopt,                       [&](bool) { this->binary(); },  Precedence::PREC_FACTOR };
-    m_rules[TokenType::STAR]            = { std::nullopt,                       [&](bool) { this->binary(); },  Precedence::PREC_FACTOR };
-    m_rules[TokenType::BANG]            = { [&](bool) { this->unary(); },       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::BANG_EQUAL]      = { std::nullopt,                       [&](bool) { this->binary(); },  Precedence::PREC_EQUALITY };
-    m_rules[TokenType::EQUAL]           = { std::nullopt,                       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::EQUAL_EQUAL]     = { std::nullopt,                       [&](bool) { this->binary(); },  Precedence::PREC_EQUALITY };
-    m_rules[TokenType::GREATER]         = { std::nullopt,                       [&](bool) { this->binary(); },  Precedence::PREC_COMPARISON };
-    m_rules[TokenType::GREATER_EQUAL]   = { std::nullopt,                       [&](bool) { this->binary(); },  Precedence::PREC_COMPARISON };
-    m_rules[TokenType::LESS]            = { std::nullopt,                       [&](bool) { this->binary(); },  Precedence::PREC_COMPARISON };
-    m_rules[TokenType::LESS_EQUAL]      = { std::nullopt,                       [&](bool) { this->binary(); },  Precedence::PREC_COMPARISON };
-    m_rules[TokenType::STRING]          = { [&](bool) { this->string(); },      std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::NUMBER]          = { [&](bool) { this->number(); },      std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::AND]             = { std::nullopt,                       [&](bool) { this->and_(); },    Precedence::PREC_AND };
-    m_rules[TokenType::CLASS]           = { std::nullopt,                       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::ELSE]            = { std::nullopt,                       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::FALSE]           = { [&](bool) { this->literal(); },     std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::FOR]             = { std::nullopt,                       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::FUN]             = { std::nullopt,                       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::IF]              = { std::nullopt,                       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::NIL]             = { [&](bool) { this->literal(); },     std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::OR]              = { std::nullopt,                       [&](bool) { this->or_(); },     Precedence::PREC_OR };
-    m_rules[TokenType::PRINT]           = { std::nullopt,                       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::RETURN]          = { std::nullopt,                       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::SUPER]           = { std::nullopt,                       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::THIS]            = { std::nullopt,                       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::TRUE]            = { [&](bool) { this->literal(); },     std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::VAR]             = { std::nullopt,                       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::WHILE]           = { std::nullopt,                       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::ERROR]           = { std::nullopt,                       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::END_OF_FILE]     = { std::nullopt,                       std::nullopt,                   Precedence::PREC_NONE };
-    m_rules[TokenType::IDENTIFIER]      = { [&](bool canAssign) { this->variable(canAssign); }, std::nullopt,   Precedence::PREC_NONE }; }
-
-auto SpicyCompiler::compile() -> Func {
-    m_function = { .object = nullptr, .arity = 0, .chunk = {}, .name = "" };
-    //m_locals.emplace_back({ .name = { .type = TokenType::ERROR, .lexeme = "", .literal = std::nullopt, .line = -1 }, .depth = 0});
-    //m_chunk = Chunk(); // reset the current chunk
-    advance();
-    
-    while (!match(TokenType::END_OF_FILE)) {
-        declaration();
-    }
-    
-    return m_function;
-}
-
-void SpicyCompiler::advance() {
-    m_previous = m_current;
-    while (true) {
-        m_current = m_scanner.scanSingle();
-        if (m_current.type != TokenType::ERROR) break;
-        errorAtCurrent(m_current.lexeme);
-    }
-}
-
-void SpicyCompiler::consume(TokenType type, const std::string& errMsg) {
-    if (m_current.type == type) {
-        advance();
-        return;
+SpicyCompiler::SpicyCompiler(const eval::ResolvedLocals& resolvedLocals, std::shared_ptr<CompileStats> stats)
+    : m_resolvedLocals(resolvedLocals), m_stats(std::move(stats)) {}
+
+auto SpicyCompiler::compile(std::span<const ast::StmtPtrVariant> program) -> Func {
+    auto script = Func{ .object = nullptr, .arity = 0, .chunk = {}, .name = "script" };
+    auto state = FunctionState{ .chunk = &script.chunk, .type = FuncType::SCRIPT };
+    m_current = &state;
+    m_scopeDepth = 0;
+
+    // slot 0 is reserved for the callee, the script doesn't have one but keeps the layout identical
+    addLocal("");
+    markInitialized();
+    // a script defining its own len() or sqrt() can't have those calls treated as pure
+    auto userGlobals = std::make_shared<std::set<std::string>>();
+    for (const auto& stmt : program) {
+        if (std::holds_alternative<ast::VarStmtPtr>(stmt)) userGlobals->insert(std::get<ast::VarStmtPtr>(stmt)->varName.lexeme);
+        else if (std::holds_alternative<ast::FuncStmtPtr>(stmt)) userGlobals->insert(std::get<ast::FuncStmtPtr>(stmt)->funcName.lexeme);
+        else if (std::holds_alternative<ast::ClassStmtPtr>(stmt)) userGlobals->insert(std::get<ast::ClassStmtPtr>(stmt)->className.lexeme);
     }
-    errorAtCurrent(errMsg);
-}
+    m_userGlobals = std::move(userGlobals);
+    for (const auto& stmt : program) {
+        compileStmt(stmt);
+    }
+    emitByte(Chunk::OpCode::OP_NIL);
+    emitByte(Chunk::OpCode::OP_RETURN);
 
-bool SpicyCompiler::match(TokenType type) {
-    if (!check(type)) return false;
-    advance();
-    return true;
+    m_current = nullptr;
+    return script;
 }
 
-bool SpicyCompiler::check(TokenType type) {
-    return m_current.type == type;
+auto SpicyCompiler::hadError() const -> bool {
+    return m_hadError;
 }
 
 // ===============================================================================================================================
-// BYTECODE GENERATION FUNCTIONS
+// STATEMENTS
 // ===============================================================================================================================
 
-void SpicyCompiler::emitByte(uint8_t byte) {
-    m_function.chunk.appendByte(byte, m_previous.line);
+struct SpicyStmtCompiler {
+    SpicyCompiler* const compiler;
+    explicit SpicyStmtCompiler(SpicyCompiler* compiler) : compiler(compiler) {}
+    void operator()(const ast::ExprStmtPtr& stmt) { compiler->compileExprStmt(stmt); }
+    void operator()(const ast::PrintStmtPtr& stmt) { compiler->compilePrintStmt(stmt); }
+    void operator()(const ast::BlockStmtPtr& stmt) { compiler->compileBlockStmt(stmt); }
+    void operator()(const ast::VarStmtPtr& stmt) { compiler->compileVarStmt(stmt); }
+    void operator()(const ast::IfStmtPtr& stmt) { compiler->compileIfStmt(stmt); }
+    void operator()(const ast::WhileStmtPtr& stmt) { compiler->compileWhileStmt(stmt); }
+    void operator()(const ast::FuncStmtPtr& stmt) { compiler->compileFuncStmt(stmt); }
+    void operator()(const ast::RetStmtPtr& stmt) { compiler->compileRetStmt(stmt); }
+    void operator()(const ast::ClassStmtPtr& stmt) { compiler->compileClassStmt(stmt); }
+};
+
+void SpicyCompiler::compileStmt(const ast::StmtPtrVariant& stmt) {
+    std::visit(SpicyStmtCompiler(this), stmt);
+}
+
+void SpicyCompiler::compileStmts(const std::vector<ast::StmtPtrVariant>& stmts) {
+    for (const auto& stmt : stmts) {
+        compileStmt(stmt);
+    }
 }
 
-void SpicyCompiler::emitByte(Chunk::OpCode byte) {
-    emitByte(static_cast<uint8_t>(byte));
+void SpicyCompiler::compileExprStmt(const ast::ExprStmtPtr& stmt) {
+    // the parser leaves a null statement behind when it has to synchronize
+    if (stmt == nullptr) return;
+    compileExpr(stmt->expression);
+    emitByte(Chunk::OpCode::OP_POP);
 }
 
-void SpicyCompiler::emitBytes(uint8_t byte1, uint8_t byte2) {
-    emitByte(byte1);
-    emitByte(byte2);
+void SpicyCompiler::compilePrintStmt(const ast::PrintStmtPtr& stmt) {
+    compileExpr(stmt->expression);
+    emitByte(Chunk::OpCode::OP_PRINT);
 }
 
-void SpicyCompiler::emitBytes(Chunk::OpCode byte1, uint8_t byte2) {
-    emitByte(byte1);
-    emitByte(byte2);
+void SpicyCompiler::compileBlockStmt(const ast::BlockStmtPtr& stmt) {
+    // scope depths have to keep matching the resolver's distances
+    if (!stmt->hasScope) {
+        compileStmts(stmt->statements);
+        return;
+    }
+    beginScope();
+    compileStmts(stmt->statements);
+    endScope();
 }
 
-void SpicyCompiler::emitBytes(Chunk::OpCode byte1, Chunk::OpCode byte2) {
-    emitByte(byte1);
-    emitByte(byte2);
+void SpicyCompiler::compileVarStmt(const ast::VarStmtPtr& stmt) {
+    m_line = stmt->varName.line;
+    const auto isLocal = m_scopeDepth > 0;
+    if (isLocal) {
+        // the initializer's value lands right in the new local's slot
+        addLocal(stmt->varName.lexeme);
+    }
+    if (stmt->initializer.has_value()) {
+        compileExpr(stmt->initializer.value());
+    } else {
+        emitByte(Chunk::OpCode::OP_NIL);
+    }
+    if (isLocal) {
+        markInitialized();
+    } else {
+        emitBytes(Chunk::OpCode::OP_DEFINE_GLOBAL, identifierConstant(stmt->varName.lexeme));
+    }
 }
 
-void SpicyCompiler::emitReturn() {
-    emitByte(Chunk::OpCode::OP_RETURN);
-}
+void SpicyCompiler::compileIfStmt(const ast::IfStmtPtr& stmt) {
+    compileExpr(stmt->condition);
 
-void SpicyCompiler::emitConstant(SpicyObj constant) {
-    emitBytes(static_cast<uint8_t>(Chunk::OpCode::OP_CONSTANT), makeConstant(constant));
-}
+    const auto thenJump = emitJump(Chunk::OpCode::OP_JUMP_IF_FALSE);
+    emitByte(Chunk::OpCode::OP_POP);
+    compileStmt(stmt->thenBranch);
 
-void SpicyCompiler::emitLoop(uint32_t loopStart) {
-    emitByte(Chunk::OpCode::OP_LOOP);
+    const auto elseJump = emitJump(Chunk::OpCode::OP_JUMP);
+    patchJump(thenJump);
+    emitByte(Chunk::OpCode::OP_POP);
 
-    auto offset = m_chunk.getBytecodeCount() - loopStart + 2;
-    if (offset > std::numeric_limits<uint16_t>::max()) {
-        error("Too much code to jump over in loop.");
+    if (stmt->elseBranch.has_value()) {
+        compileStmt(stmt->elseBranch.value());
     }
-    
-    emitByte((offset >> 8) & 0xff);
-    emitByte(offset & 0xff);
+    patchJump(elseJump);
 }
 
-uint16_t SpicyCompiler::emitJump(Chunk::OpCode byte) {
-    emitByte(byte);
-    // emit temporary offset (two bytes) to be set later when the proper values are known
-    emitByte(0xff);
-    emitByte(0xff);
-    return m_chunk.getBytecodeCount() - 2;
-}
+void SpicyCompiler::compileWhileStmt(const ast::WhileStmtPtr& stmt) {
+    const auto invariants = opt::findLoopInvariants(stmt, m_scopeDepth, m_resolvedLocals, *m_userGlobals, m_hoisted);
+    // the condition runs at least once, whatever it computes can be computed up front
+    hoist(invariants.condition);
 
-void SpicyCompiler::patchJump(uint16_t offset) {
-    auto jump = m_chunk.getBytecodeCount() - offset - 2;
-    
-    if (jump > std::numeric_limits<uint16_t>::max()) {
-        error("Too much code to jump over.");
-    }
-    
-    m_chunk.setBytecodeValue(offset, (jump >> 8) & 0xff);
-    m_chunk.setBytecodeValue(offset + 1, jump & 0xff);
-}
+    if (invariants.body.empty()) {
+        const auto loopStart = static_cast<size_t>(m_current->chunk->getBytecodeCount());
+        compileExpr(stmt->condition);
 
-uint8_t SpicyCompiler::makeConstant(SpicyObj constant) {
-    const auto idx = m_chunk.addConstant(constant);
-    if (idx > std::numeric_limits<uint8_t>::max()) {
-        error("Too many constants in one chunk");
-        return 0;
-    }
-    return idx;
-}
+        const auto exitJump = emitJump(Chunk::OpCode::OP_JUMP_IF_FALSE);
+        emitByte(Chunk::OpCode::OP_POP);
+        compileStmt(stmt->loopBody);
+        emitLoop(loopStart);
 
-// ===============================================================================================================================
-// ERROR FUNCTIONS
-// ===============================================================================================================================
+        patchJump(exitJump);
+        emitByte(Chunk::OpCode::OP_POP);
+    } else {
+        // the body's invariants can only be computed once we know it runs, so the first test gets pulled
+        // in front of them and the loop tests at the bottom from there on
+        compileExpr(stmt->condition);
+        const auto skipJump = emitJump(Chunk::OpCode::OP_JUMP_IF_FALSE);
+        emitByte(Chunk::OpCode::OP_POP);
+        hoist(invariants.body);
 
-void SpicyCompiler::error(const std::string& msg) {
-    errorAt(m_previous, msg);
-}
+        const auto loopStart = static_cast<size_t>(m_current->chunk->getBytecodeCount());
+        compileStmt(stmt->loopBody);
+        compileExpr(stmt->condition);
+        const auto exitJump = emitJump(Chunk::OpCode::OP_JUMP_IF_FALSE);
+        emitByte(Chunk::OpCode::OP_POP);
+        emitLoop(loopStart);
 
-void SpicyCompiler::errorAtCurrent(const std::string& msg) {
-    errorAt(m_current, msg);
+        patchJump(exitJump);
+        emitByte(Chunk::OpCode::OP_POP);
+        unhoist(invariants.body);
+        const auto endJump = emitJump(Chunk::OpCode::OP_JUMP);
+
+        patchJump(skipJump);
+        emitByte(Chunk::OpCode::OP_POP);
+        patchJump(endJump);
+    }
+    unhoist(invariants.condition);
 }
 
-void SpicyCompiler::errorAt(const Token& token, const std::string& msg) {
-    if (m_panicMode) return;
-    m_panicMode = true;
-    std::cout << std::format("[line {}] Error", token.line);
-    if (token.type == TokenType::END_OF_FILE) std::cout << " at end";
-    //else if (token.type == TokenType::)
-    else std::cout << std::format(" at '{}'", token.lexeme);
-    std::cout << std::format(": {}\n", msg);
-    m_hadError = true;
+void SpicyCompiler::compileFuncStmt(const ast::FuncStmtPtr& stmt) {
+    m_line = stmt->funcName.line;
+    if (m_scopeDepth > 0) {
+        // mark it initialized right away so the function can refer to itself
+        addLocal(stmt->funcName.lexeme);
+        markInitialized();
+        compileFunction(stmt->funcExpr, stmt->funcName.lexeme);
+    } else {
+        compileFunction(stmt->funcExpr, stmt->funcName.lexeme);
+        emitBytes(Chunk::OpCode::OP_DEFINE_GLOBAL, identifierConstant(stmt->funcName.lexeme));
+    }
 }
 
-void SpicyCompiler::synchronize() {
-    m_panicMode = false;
-    while (check(TokenType::END_OF_FILE)) {
-        if (m_previous.type == TokenType::SEMICOLON) return;
-        switch (m_current.type) {
-        case TokenType::CLASS:
-        case TokenType::FUN:
-        case TokenType::VAR:
-        case TokenType::FOR:
-        case TokenType::IF:
-        case TokenType::WHILE:
-        case TokenType::PRINT:
-        case TokenType::RETURN:
-            return;
-        default: advance();
-        }
+void SpicyCompiler::compileRetStmt(const ast::RetStmtPtr& stmt) {
+    m_line = stmt->ret.line;
+    if (stmt->value.has_value()) {
+        compileExpr(stmt->value.value());
+    } else {
+        emitByte(Chunk::OpCode::OP_NIL);
     }
+    emitByte(Chunk::OpCode::OP_RETURN);
 }
 
+void SpicyCompiler::compileClassStmt(const ast::ClassStmtPtr& stmt) {
+    unsupported(stmt->className, "Classes");
+}
 
 // ===============================================================================================================================
-// PARSER FUNCTIONS
+// EXPRESSIONS
 // ===============================================================================================================================
 
-void SpicyCompiler::parsePrecedence(Precedence prec) {
-    advance();
-    const auto& prefixRuleOpt = m_rules[m_previous.type].prefix;
-    if (!prefixRuleOpt.has_value()) {
-        error("Expect expression.");
+struct SpicyExprCompiler {
+    SpicyCompiler* const compiler;
+    explicit SpicyExprCompiler(SpicyCompiler* compiler) : compiler(compiler) {}
+    void operator()(const ast::BinaryExprPtr& expr) { compiler->compileBinaryExpr(expr); }
+    void operator()(const ast::GroupingExprPtr& expr) { compiler->compileGroupingExpr(expr); }
+    void operator()(const ast::LiteralExprPtr& expr) { compiler->compileLiteralExpr(expr); }
+    void operator()(const ast::UnaryExprPtr& expr) { compiler->compileUnaryExpr(expr); }
+    void operator()(const ast::ConditionalExprPtr& expr) { compiler->error("Conditional expressions are not supported by the bytecode compiler yet."); }
+    void operator()(const ast::PostfixExprPtr& expr) { compiler->compilePostfixExpr(expr); }
+    void operator()(const ast::VariableExprPtr& expr) { compiler->compileVariableExpr(expr); }
+    void operator()(const ast::AssignExprPtr& expr) { compiler->compileAssignExpr(expr); }
+    void operator()(const ast::LogicalExprPtr& expr) { compiler->compileLogicalExpr(expr); }
+    void operator()(const ast::CallExprPtr& expr) { compiler->compileCallExpr(expr); }
+    void operator()(const ast::FuncExprPtr& expr) { compiler->compileFuncExpr(expr); }
+    void operator()(const ast::GetExprPtr& expr) { compiler->unsupported(expr->name, "Properties"); }
+    void operator()(const ast::SetExprPtr& expr) { compiler->unsupported(expr->name, "Properties"); }
+    void operator()(const ast::ThisExprPtr& expr) { compiler->unsupported(expr->keyword, "Classes"); }
+    void operator()(const ast::SuperExprPtr& expr) { compiler->unsupported(expr->keyword, "Classes"); }
+    void operator()(const ast::IndexGetExprPtr& expr) { compiler->compileIndexGetExpr(expr); }
+    void operator()(const ast::IndexSetExprPtr& expr) { compiler->compileIndexSetExpr(expr); }
+};
+
+void SpicyCompiler::compileExpr(const ast::ExprPtrVariant& expr) {
+    if (const auto hoisted = m_hoisted.find(opt::exprAddress(expr)); hoisted != m_hoisted.end()) {
+        emitBytes(Chunk::OpCode::OP_GET_LOCAL, hoisted->second);
         return;
     }
-    const auto& prefixRule = prefixRuleOpt.value();
-    const auto canAssign = prec <= Precedence::PREC_ASSIGNMENT;
-    prefixRule(canAssign);
-    
-    while (prec <= m_rules[m_current.type].precedence) {
-        advance();
-        const auto& infixRuleOpt = m_rules[m_previous.type].infix;
-        if (!infixRuleOpt.has_value()) {
-            error("Expect infix expression.");
-            return;
-        }
-        const auto& infixRule = infixRuleOpt.value();
-        infixRule(canAssign);
-    }
-    
-    if (canAssign && match(TokenType::EQUAL)) {
-        error("Invalid assignment target.");
+    if (const auto folded = opt::foldNumber(expr); folded.has_value()) {
+        emitConstant(folded.value());
+        return;
     }
+    std::visit(SpicyExprCompiler(this), expr);
 }
 
-void SpicyCompiler::declaration() {
-    if (match(TokenType::VAR)) {
-        varDeclaration();
-    } else {
-        statement();
-    }
-    
-    if (m_panicMode) {
-        synchronize();
+void SpicyCompiler::compileBinaryExpr(const ast::BinaryExprPtr& expr) {
+    compileExpr(expr->left);
+    compileExpr(expr->right);
+    m_line = expr->op.line;
+    switch (expr->op.type) {
+    case TokenType::BANG_EQUAL:     emitBytes(Chunk::OpCode::OP_EQUAL, Chunk::OpCode::OP_NOT); break;
+    case TokenType::EQUAL_EQUAL:    emitByte(Chunk::OpCode::OP_EQUAL); break;
+    case TokenType::GREATER:        emitByte(Chunk::OpCode::OP_GREATER); break;
+    case TokenType::GREATER_EQUAL:  emitBytes(Chunk::OpCode::OP_LESS, Chunk::OpCode::OP_NOT); break;
+    case TokenType::LESS:           emitByte(Chunk::OpCode::OP_LESS); break;
+    case TokenType::LESS_EQUAL:     emitBytes(Chunk::OpCode::OP_GREATER, Chunk::OpCode::OP_NOT); break;
+    case TokenType::PLUS:           emitByte(Chunk::OpCode::OP_ADD); break;
+    case TokenType::MINUS:          emitByte(Chunk::OpCode::OP_SUBTRACT); break;
+    case TokenType::STAR:           emitByte(Chunk::OpCode::OP_MULTIPLY); break;
+    case TokenType::SLASH:          emitByte(Chunk::OpCode::OP_DIVIDE); break;
+    case TokenType::ARROW:          emitByte(Chunk::OpCode::OP_APPEND); break;
+    case TokenType::RARROW:         emitByte(Chunk::OpCode::OP_PREPEND); break;
+    default:
+        error(expr->op, "Unexpected operator in binary expression.");
     }
 }
 
-void SpicyCompiler::varDeclaration() {
-    const auto global = parseVar("Expect variable name.");
-    if (match(TokenType::EQUAL)) {
-        expression();
-    } else {
-        emitByte(Chunk::OpCode::OP_NIL);
+void SpicyCompiler::compileGroupingExpr(const ast::GroupingExprPtr& expr) {
+    compileExpr(expr->expression);
+}
+
+void SpicyCompiler::compileLiteralExpr(const ast::LiteralExprPtr& expr) {
+    const auto& value = expr->value;
+    if (expr->isList) emitByte(Chunk::OpCode::OP_LIST);
+    else if (value.is<std::nullptr_t>()) emitByte(Chunk::OpCode::OP_NIL);
+    else if (value.is<bool>())
+        emitByte(value.as<bool>() ? Chunk::OpCode::OP_TRUE : Chunk::OpCode::OP_FALSE);
+    else emitConstant(value);
+}
+
+void SpicyCompiler::compileUnaryExpr(const ast::UnaryExprPtr& expr) {
+    m_line = expr->op.line;
+    switch (expr->op.type) {
+    case TokenType::MINUS:
+        compileExpr(expr->right);
+        emitByte(Chunk::OpCode::OP_NEGATE);
+        break;
+    case TokenType::BANG:
+        compileExpr(expr->right);
+        emitByte(Chunk::OpCode::OP_NOT);
+        break;
+    case TokenType::PLUS_PLUS:
+    case TokenType::MINUS_MINUS: {
+        if (!std::holds_alternative<ast::VariableExprPtr>(expr->right)) {
+            error(expr->op, "Operand must be a variable.");
+            return;
+        }
+        const auto& varExpr = std::get<ast::VariableExprPtr>(expr->right);
+        const auto ref = resolveVariable(varExpr->id, varExpr->varName);
+        emitGet(ref);
+        emitConstant(int64_t{1});
+        emitByte(expr->op.type == TokenType::PLUS_PLUS ? Chunk::OpCode::OP_ADD : Chunk::OpCode::OP_SUBTRACT);
+        emitSet(ref);
+        break;
     }
-    consume(TokenType::SEMICOLON, "Expect ';' after var declaration");
-    defineVariable(global);
-}
-
-void SpicyCompiler::statement() {
-    if (match(TokenType::PRINT)) {
-        printStatement();
-    } else if (match(TokenType::IF)) {
-        ifStatement();
-    } else if (match(TokenType::WHILE)) {
-        whileStatement();
-    } else if (match(TokenType::FOR)) {
-        forStatement();
-    } else if (match(TokenType::LEFT_BRACE)) {
-        beginScope();
-        block();
-        endScope();
-    } else {
-        expressionStatement();
+    default:
+        error(expr->op, "Invalid unary operator.");
     }
 }
 
-void SpicyCompiler::block() {
-    while (!check(TokenType::RIGHT_BRACE) && !check(TokenType::END_OF_FILE)) {
-        declaration();
+void SpicyCompiler::compilePostfixExpr(const ast::PostfixExprPtr& expr) {
+    m_line = expr->op.line;
+    if (!std::holds_alternative<ast::VariableExprPtr>(expr->left)) {
+        error(expr->op, "Operand must be a variable.");
+        return;
     }
-    
-    consume(TokenType::RIGHT_BRACE, "Expected '}' at the end of block.");
+    const auto& varExpr = std::get<ast::VariableExprPtr>(expr->left);
+    const auto ref = resolveVariable(varExpr->id, varExpr->varName);
+    // the old value stays on the stack as the result, the updated one is popped after the store
+    emitGet(ref);
+    emitGet(ref);
+    emitConstant(int64_t{1});
+    emitByte(expr->op.type == TokenType::PLUS_PLUS ? Chunk::OpCode::OP_ADD : Chunk::OpCode::OP_SUBTRACT);
+    emitSet(ref);
+    emitByte(Chunk::OpCode::OP_POP);
 }
 
-void SpicyCompiler::printStatement() {
-    expression();
-    consume(TokenType::SEMICOLON, "Expect ';' after value.");
-    emitByte(Chunk::OpCode::OP_PRINT);
+void SpicyCompiler::compileVariableExpr(const ast::VariableExprPtr& expr) {
+    m_line = expr->varName.line;
+    emitGet(resolveVariable(expr->id, expr->varName));
 }
 
-void SpicyCompiler::ifStatement() {
-    consume(TokenType::LEFT_PAREN, "Expect '(' after 'if'.");
-    expression();
-    consume(TokenType::RIGHT_PAREN, "Expect ')' after condition.");
-    
-    auto thenJump = emitJump(Chunk::OpCode::OP_JUMP_IF_FALSE);
-    emitByte(Chunk::OpCode::OP_POP);
-    statement();
-    
-    auto elseJump = emitJump(Chunk::OpCode::OP_JUMP);
-    patchJump(thenJump);
-    emitByte(Chunk::OpCode::OP_POP);
-    
-    if (match(TokenType::ELSE)) statement();
-    patchJump(elseJump);
+void SpicyCompiler::compileAssignExpr(const ast::AssignExprPtr& expr) {
+    compileExpr(expr->right);
+    m_line = expr->varName.line;
+    emitSet(resolveVariable(expr->id, expr->varName));
 }
 
-void SpicyCompiler::whileStatement() {
-    auto loopStart = m_chunk.getBytecodeCount();
-    consume(TokenType::LEFT_PAREN, "Expect '(' after 'while'.");
-    expression();
-    consume(TokenType::RIGHT_PAREN, "Expect ')' after condition.");
-    
-    auto exitJump = emitJump(Chunk::OpCode::OP_JUMP_IF_FALSE);
-    emitByte(Chunk::OpCode::OP_POP);
-    statement();
-    emitLoop(loopStart);
-    
-    patchJump(exitJump);
-    emitByte(Chunk::OpCode::OP_POP);
-}
-
-void SpicyCompiler::forStatement() {
-    beginScope();
-    consume(TokenType::LEFT_PAREN, "Expect '(' after 'for'.");
-    //consume(TokenType::SEMICOLON, "Expect ';'.");
-    if (match(TokenType::SEMICOLON)) {
-        // no initializer
-    } else if (match(TokenType::VAR)) {
-        varDeclaration();
+void SpicyCompiler::compileLogicalExpr(const ast::LogicalExprPtr& expr) {
+    compileExpr(expr->left);
+    m_line = expr->op.line;
+    if (expr->op.type == TokenType::AND) {
+        const auto endJump = emitJump(Chunk::OpCode::OP_JUMP_IF_FALSE);
+        emitByte(Chunk::OpCode::OP_POP);
+        compileExpr(expr->right);
+        patchJump(endJump);
     } else {
-        // this looks for a ';' at the end and also emits a pop instruction, which is what we want
-        expressionStatement();
-    }
-    auto loopStart = m_chunk.getBytecodeCount();
-    auto exitJump = -1;
-    
-    if (!match(TokenType::SEMICOLON)) {
-        expression();
-        consume(TokenType::SEMICOLON, "Expect ';' after loop condition.");
-
-        exitJump = emitJump(Chunk::OpCode::OP_JUMP_IF_FALSE);
+        const auto elseJump = emitJump(Chunk::OpCode::OP_JUMP_IF_FALSE);
+        const auto endJump = emitJump(Chunk::OpCode::OP_JUMP);
+        patchJump(elseJump);
         emitByte(Chunk::OpCode::OP_POP);
+        compileExpr(expr->right);
+        patchJump(endJump);
     }
-    
-    if (!match(TokenType::RIGHT_PAREN)) {
-        auto bodyJump = emitJump(Chunk::OpCode::OP_JUMP);
-        auto incStart = m_chunk.getBytecodeCount();
-        
-        expression();
-        
-        emitByte(Chunk::OpCode::OP_POP);
-        consume(TokenType::RIGHT_PAREN, "Expect ')' after 'for' clauses.");
+}
 
-        emitLoop(loopStart);
-        loopStart = incStart;
-        patchJump(bodyJump);
-    }
-    
-    statement();
-    emitLoop(loopStart);
-    
-    if (exitJump != -1) {
-        patchJump(exitJump);
-        emitByte(Chunk::OpCode::OP_POP);
+void SpicyCompiler::compileCallExpr(const ast::CallExprPtr& expr) {
+    compileExpr(expr->callee);
+    for (const auto& arg : expr->arguments) {
+        compileExpr(arg);
     }
-    endScope();
+    m_line = expr->paren.line;
+    if (expr->arguments.size() > std::numeric_limits<uint8_t>::max()) {
+        error(expr->paren, "Can't have more than 255 arguments.");
+        return;
+    }
+    emitBytes(Chunk::OpCode::OP_CALL, static_cast<uint8_t>(expr->arguments.size()));
 }
 
-void SpicyCompiler::expressionStatement() {
-    expression();
-    consume(TokenType::SEMICOLON, "Expect ';' after expression.");
-    emitByte(Chunk::OpCode::OP_POP);
+void SpicyCompiler::compileFuncExpr(const ast::FuncExprPtr& expr) {
+    compileFunction(expr, "___lambda");
 }
 
-void SpicyCompiler::expression() {
-    parsePrecedence(Precedence::PREC_ASSIGNMENT);
+void SpicyCompiler::compileIndexGetExpr(const ast::IndexGetExprPtr& expr) {
+    compileExpr(expr->lst);
+    compileExpr(expr->idx);
+    m_line = expr->lbracket.line;
+    emitByte(Chunk::OpCode::OP_GET_INDEX);
 }
 
-void SpicyCompiler::variable(bool canAssign) {
-    namedVariable(m_previous, canAssign);
+void SpicyCompiler::compileIndexSetExpr(const ast::IndexSetExprPtr& expr) {
+    compileExpr(expr->lst);
+    compileExpr(expr->idx);
+    compileExpr(expr->val);
+    m_line = expr->lbracket.line;
+    emitByte(Chunk::OpCode::OP_SET_INDEX);
 }
 
-void SpicyCompiler::namedVariable(const spicy::Token& name, bool canAssign) {
-    Chunk::OpCode getOp, setOp;
-    auto arg = resolveLocal(name);
-    if (arg != -1) {
-        getOp = Chunk::OpCode::OP_GET_LOCAL;
-        setOp = Chunk::OpCode::OP_SET_LOCAL;
-    } else {
-        arg = identifierConst(name);
-        getOp = Chunk::OpCode::OP_GET_GLOBAL;
-        setOp = Chunk::OpCode::OP_SET_GLOBAL;
-    }
-    
-    if (canAssign && match(TokenType::EQUAL)) {
-        expression();
-        emitBytes(setOp, arg);
-    } else {
-		emitBytes(getOp, arg);
-    }
+void SpicyCompiler::unsupported(const Token& token, const std::string& what) {
+    error(token, std::format("{} are not supported by the bytecode compiler yet.", what));
 }
 
-void SpicyCompiler::number() {
-    emitConstant(std::get<double>(m_previous.literal.value()));
-}
+// ===============================================================================================================================
+// LOOPS
+// ===============================================================================================================================
 
-void SpicyCompiler::literal() {
-    switch (m_previous.type) {
-    case TokenType::FALSE: emitByte(Chunk::OpCode::OP_FALSE); break;
-    case TokenType::TRUE: emitByte(Chunk::OpCode::OP_TRUE); break;
-    case TokenType::NIL: emitByte(Chunk::OpCode::OP_NIL); break;
-    default: return;
+// each value gets a nameless local, nothing can refer to it other than the expression it replaces
+void SpicyCompiler::hoist(const std::vector<const ast::ExprPtrVariant*>& exprs) {
+    for (const auto* expr : exprs) {
+        compileExpr(*expr);
+        addLocal("");
+        markInitialized();
+        m_hoisted.insert_or_assign(opt::exprAddress(*expr), static_cast<uint8_t>(m_current->locals.size() - 1));
     }
 }
 
-void SpicyCompiler::grouping() {
-    expression();
-    consume(TokenType::RIGHT_PAREN, "Expect ')' after expression.");
+// the hidden locals sit on top of the loop's scope, the body's own locals are gone by the time we get here
+void SpicyCompiler::unhoist(const std::vector<const ast::ExprPtrVariant*>& exprs) {
+    for (auto it = exprs.rbegin(); it != exprs.rend(); ++it) {
+        emitByte(Chunk::OpCode::OP_POP);
+        m_current->locals.pop_back();
+        m_hoisted.erase(opt::exprAddress(**it));
+    }
 }
 
-void SpicyCompiler::unary() {
-    const auto opType = m_previous.type;
-    parsePrecedence(Precedence::PREC_UNARY);
-    switch (opType) {
-    case TokenType::MINUS: emitByte(Chunk::OpCode::OP_NEGATE); break;
-    case TokenType::BANG: emitByte(Chunk::OpCode::OP_NOT); break;
-    // TODO: inc, dec
-    default: return;
+// ===============================================================================================================================
+// FUNCTIONS
+// ===============================================================================================================================
+
+void SpicyCompiler::compileFunction(const ast::FuncExprPtr& decl, const std::string& name) {
+    // the parameters live one scope below the declaration
+    const auto baseDepth = m_scopeDepth + 1;
+    auto captures = findCaptures(decl, baseDepth);
+    if (captures.size() > std::numeric_limits<uint8_t>::max()) {
+        error("Too many closure variables in function.");
+        return;
     }
-}
 
-void SpicyCompiler::binary() {
-    const auto opType = m_previous.type;
-    const auto& rule = m_rules[opType];
-    parsePrecedence((Precedence)((int)rule.precedence + 1)); // TODO: that's bad
-    
-    switch (opType) {
-    case TokenType::BANG_EQUAL:     emitBytes(Chunk::OpCode::OP_EQUAL, Chunk::OpCode::OP_NOT); break;
-    case TokenType::EQUAL_EQUAL:    emitByte(Chunk::OpCode::OP_EQUAL); break;
-    case TokenType::GREATER:        emitByte(Chunk::OpCode::OP_GREATER); break;
-    case TokenType::GREATER_EQUAL:  emitBytes(Chunk::OpCode::OP_LESS, Chunk::OpCode::OP_NOT); break;
-    case TokenType::LESS:           emitByte(Chunk::OpCode::OP_LESS); break;
-    case TokenType::LESS_EQUAL:     emitBytes(Chunk::OpCode::OP_GREATER, Chunk::OpCode::OP_NOT); break;
-    case TokenType::PLUS:           emitByte(Chunk::OpCode::OP_ADD); break;
-    case TokenType::MINUS:          emitByte(Chunk::OpCode::OP_SUBTRACT); break;
-    case TokenType::STAR:           emitByte(Chunk::OpCode::OP_MULTIPLY); break;
-    case TokenType::SLASH:          emitByte(Chunk::OpCode::OP_DIVIDE); break;
-    // TODO: append
-    default: return;
+    // everything the body needs from us is in the captures, a fresh compiler can take it from there
+    auto body = std::make_shared<FuncBody>();
+    body->compileBody = [&decl, baseDepth, captures, &resolvedLocals = m_resolvedLocals, stats = m_stats, userGlobals = m_userGlobals](Chunk& chunk) {
+        auto compiler = SpicyCompiler(resolvedLocals, stats);
+        compiler.m_userGlobals = userGlobals;
+        return compiler.compileBody(decl, baseDepth, captures, chunk);
+    };
+    auto function = makeRef<FuncObj>(name, decl->parameters.size(), std::move(body));
+    m_stats->functions++;
+
+    emitBytes(Chunk::OpCode::OP_CLOSURE, makeConstant(std::move(function)));
+    emitByte(static_cast<uint8_t>(captures.size()));
+    for (const auto& capture : captures) {
+        if (const auto local = resolveLocal(capture.name, capture.depth); local != -1) {
+            m_current->locals[local].isCaptured = true;
+            emitByte(1);
+            emitByte(static_cast<uint8_t>(local));
+        } else if (const auto upvalue = resolveCapture(capture.name, capture.depth); upvalue != -1) {
+            emitByte(0);
+            emitByte(static_cast<uint8_t>(upvalue));
+        } else {
+            error(std::format("Unable to resolve captured variable {}.", capture.name));
+        }
     }
 }
 
-void SpicyCompiler::string() {
-    if (m_previous.literal.has_value() &&
-        std::holds_alternative<std::string>(m_previous.literal.value())) {
-        emitConstant(std::get<std::string>(m_previous.literal.value()));
-    } else {
-        errorAt(m_previous, "Expected string literal.");
+auto SpicyCompiler::compileBody(const ast::FuncExprPtr& decl, uint32_t baseDepth, std::vector<Capture> captures, Chunk& chunk) -> bool {
+    auto state = FunctionState{ .chunk = &chunk, .type = FuncType::FUNCTION, .baseDepth = baseDepth, .captures = std::move(captures) };
+    m_current = &state;
+    m_scopeDepth = baseDepth;
+
+    addLocal("");
+    markInitialized();
+    for (const auto& param : decl->parameters) {
+        addLocal(param.lexeme);
+        markInitialized();
+    }
+    compileStmts(decl->body);
+    emitByte(Chunk::OpCode::OP_NIL);
+    emitByte(Chunk::OpCode::OP_RETURN);
+    // no endScope(), returning discards the whole frame anyway
+
+    m_current = nullptr;
+    m_stats->compiledBodies++;
+    return !m_hadError;
+}
+
+namespace {
+
+// collects the variables a function body uses that live outside of it, nested functions included
+struct CaptureScanner {
+    const eval::ResolvedLocals& resolvedLocals;
+    const uint32_t baseDepth;
+    uint32_t depth;
+    std::vector<Capture> captures;
+
+    void use(ast::NodeId id, const std::string& name) {
+        const auto resolved = resolvedLocals.find(id);
+        if (!resolved.has_value()) return;
+        const auto declDepth = depth - resolved->distance;
+        if (declDepth >= baseDepth) return;
+        const auto known = std::ranges::any_of(captures, [&](const Capture& capture) {
+            return capture.depth == declDepth && capture.name == name;
+        });
+        if (!known) captures.emplace_back(Capture{ .name = name, .depth = declDepth });
+    }
+
+    void function(const ast::FuncExprPtr& decl) {
+        depth++;
+        stmts(decl->body);
+        depth--;
+    }
+
+    void stmts(const std::vector<ast::StmtPtrVariant>& stmts) {
+        for (const auto& stmt : stmts) {
+            std::visit([this](const auto& node) { (*this)(node); }, stmt);
+        }
     }
+
+    void expr(const ast::ExprPtrVariant& expr) {
+        std::visit([this](const auto& node) { (*this)(node); }, expr);
+    }
+
+    void operator()(const ast::ExprStmtPtr& stmt) { if (stmt != nullptr) expr(stmt->expression); }
+    void operator()(const ast::PrintStmtPtr& stmt) { expr(stmt->expression); }
+    void operator()(const ast::BlockStmtPtr& stmt) {
+        if (stmt->hasScope) depth++;
+        stmts(stmt->statements);
+        if (stmt->hasScope) depth--;
+    }
+    void operator()(const ast::VarStmtPtr& stmt) { if (stmt->initializer.has_value()) expr(stmt->initializer.value()); }
+    void operator()(const ast::IfStmtPtr& stmt) {
+        expr(stmt->condition);
+        std::visit([this](const auto& node) { (*this)(node); }, stmt->thenBranch);
+        if (stmt->elseBranch.has_value()) std::visit([this](const auto& node) { (*this)(node); }, stmt->elseBranch.value());
+    }
+    void operator()(const ast::WhileStmtPtr& stmt) {
+        expr(stmt->condition);
+        std::visit([this](const auto& node) { (*this)(node); }, stmt->loopBody);
+    }
+    void operator()(const ast::FuncStmtPtr& stmt) { function(stmt->funcExpr); }
+    void operator()(const ast::RetStmtPtr& stmt) { if (stmt->value.has_value()) expr(stmt->value.value()); }
+    void operator()(const ast::ClassStmtPtr&) {} // not supported by the compiler
+
+    void operator()(const ast::BinaryExprPtr& e) { expr(e->left); expr(e->right); }
+    void operator()(const ast::GroupingExprPtr& e) { expr(e->expression); }
+    void operator()(const ast::LiteralExprPtr&) {}
+    void operator()(const ast::UnaryExprPtr& e) { expr(e->right); }
+    void operator()(const ast::ConditionalExprPtr& e) { expr(e->condition); expr(e->thenBranch); expr(e->elseBranch); }
+    void operator()(const ast::PostfixExprPtr& e) { expr(e->left); }
+    void operator()(const ast::VariableExprPtr& e) { use(e->id, e->varName.lexeme); }
+    void operator()(const ast::AssignExprPtr& e) {
+        expr(e->right);
+        use(e->id, e->varName.lexeme);
+    }
+    void operator()(const ast::LogicalExprPtr& e) { expr(e->left); expr(e->right); }
+    void operator()(const ast::CallExprPtr& e) {
+        expr(e->callee);
+        for (const auto& arg : e->arguments) expr(arg);
+    }
+    void operator()(const ast::FuncExprPtr& e) { function(e); }
+    void operator()(const ast::GetExprPtr& e) { expr(e->object); }
+    void operator()(const ast::SetExprPtr& e) { expr(e->object); expr(e->value); }
+    void operator()(const ast::ThisExprPtr&) {}
+    void operator()(const ast::SuperExprPtr&) {}
+    void operator()(const ast::IndexGetExprPtr& e) { expr(e->lst); expr(e->idx); }
+    void operator()(const ast::IndexSetExprPtr& e) { expr(e->lst); expr(e->idx); expr(e->val); }
+};
+
+} // namespace
+
+auto SpicyCompiler::findCaptures(const ast::FuncExprPtr& decl, uint32_t baseDepth) const -> std::vector<Capture> {
+    auto scanner = CaptureScanner{ .resolvedLocals = m_resolvedLocals, .baseDepth = baseDepth, .depth = baseDepth };
+    scanner.stmts(decl->body);
+    return std::move(scanner.captures);
 }
 
-void SpicyCompiler::and_() {
-    auto endJump = emitJump(Chunk::OpCode::OP_JUMP_IF_FALSE);
-    emitByte(Chunk::OpCode::OP_POP);
-    parsePrecedence(Precedence::PREC_AND);
-    patchJump(endJump);
+// ===============================================================================================================================
+// BYTECODE GENERATION FUNCTIONS
+// ===============================================================================================================================
+
+void SpicyCompiler::emitByte(uint8_t byte) {
+    m_current->chunk->appendByte(byte, m_line);
 }
 
-void SpicyCompiler::or_() {
-    auto elseJump = emitJump(Chunk::OpCode::OP_JUMP_IF_FALSE);
-    auto endJump = emitJump(Chunk::OpCode::OP_JUMP);
-    
-    patchJump(elseJump);
-    emitByte(Chunk::OpCode::OP_POP);
-    
-    parsePrecedence(Precedence::PREC_OR);
-    patchJump(endJump);
+void SpicyCompiler::emitByte(Chunk::OpCode byte) {
+    emitByte(static_cast<uint8_t>(byte));
 }
 
-void SpicyCompiler::noop() {
-    // noOp
+void SpicyCompiler::emitBytes(Chunk::OpCode byte1, uint8_t byte2) {
+    emitByte(byte1);
+    emitByte(byte2);
 }
 
-void SpicyCompiler::beginScope() {
-    m_scopeDepth++; 
+void SpicyCompiler::emitBytes(Chunk::OpCode byte1, Chunk::OpCode byte2) {
+    emitByte(byte1);
+    emitByte(byte2);
 }
 
-void SpicyCompiler::endScope() {
-    m_scopeDepth--;
-    const auto erased = std::erase_if(m_locals, [&](const Local& local) { return local.depth > m_scopeDepth; });
-    for (auto i = 0; i < erased; ++i) {
-        emitByte(Chunk::OpCode::OP_POP);
+void SpicyCompiler::emitConstant(SpicyObj constant) {
+    emitBytes(Chunk::OpCode::OP_CONSTANT, makeConstant(std::move(constant)));
+}
+
+void SpicyCompiler::emitLoop(size_t loopStart) {
+    emitByte(Chunk::OpCode::OP_LOOP);
+
+    const auto offset = m_current->chunk->getBytecodeCount() - loopStart + 2;
+    if (offset > std::numeric_limits<uint16_t>::max()) {
+        error("Too much code to jump over in loop.");
     }
+
+    emitByte((offset >> 8) & 0xff);
+    emitByte(offset & 0xff);
 }
 
-uint8_t SpicyCompiler::parseVar(const std::string& errMsg) {
-    consume(TokenType::IDENTIFIER, errMsg);
-    
-    declareVariable();
-    if (m_scopeDepth > 0) {
+size_t SpicyCompiler::emitJump(Chunk::OpCode byte) {
+    emitByte(byte);
+    // emit temporary offset (two bytes) to be set later when the proper values are known
+    emitByte(0xff);
+    emitByte(0xff);
+    return m_current->chunk->getBytecodeCount() - 2;
+}
+
+void SpicyCompiler::patchJump(size_t offset) {
+    const auto jump = m_current->chunk->getBytecodeCount() - offset - 2;
+
+    if (jump > std::numeric_limits<uint16_t>::max()) {
+        error("Too much code to jump over.");
+    }
+
+    m_current->chunk->setBytecodeValue(offset, (jump >> 8) & 0xff);
+    m_current->chunk->setBytecodeValue(offset + 1, jump & 0xff);
+}
+
+uint8_t SpicyCompiler::makeConstant(SpicyObj constant) {
+    const auto idx = m_current->chunk->addConstant(std::move(constant));
+    if (idx > std::numeric_limits<uint8_t>::max()) {
+        error("Too many constants in one chunk.");
         return 0;
     }
-    
-    return identifierConst(m_previous);
+    return static_cast<uint8_t>(idx);
 }
 
-uint8_t SpicyCompiler::identifierConst(const spicy::Token& name) {
-    return uint8_t(makeConstant(name.lexeme));
+uint8_t SpicyCompiler::identifierConstant(const std::string& name) {
+    if (const auto found = m_current->identifiers.find(name);
+        found != m_current->identifiers.end()) {
+        return found->second;
+    }
+    const auto idx = makeConstant(StringObj::intern(name));
+    m_current->identifiers.insert_or_assign(name, idx);
+    return idx;
 }
 
-void SpicyCompiler::declareVariable() {
-    if (m_scopeDepth == 0) {
-        return;
+// ===============================================================================================================================
+// VARIABLES
+// ===============================================================================================================================
+
+SpicyCompiler::VarRef SpicyCompiler::resolveVariable(ast::NodeId id, const Token& name) {
+    const auto resolved = m_resolvedLocals.find(id);
+    if (!resolved.has_value()) {
+        return { VarKind::GLOBAL, identifierConstant(name.lexeme) };
     }
-    
-    const auto& name = m_previous;
-    for (int i = m_locals.size() - 1; i >= 0; --i) {
-        const auto& local = m_locals[i];
-        if (local.depth != -1 && local.depth < m_scopeDepth) {
-            break;
+    // the resolver counts scopes the same way we do, turn its distance into the scope the variable lives in
+    const auto depth = m_scopeDepth - resolved->distance;
+    if (const auto local = resolveLocal(name.lexeme, depth); local != -1) {
+        if (!m_current->locals[local].isInitialized) {
+            error(name, "Can't read local variable in its own initializer.");
+        }
+        return { VarKind::LOCAL, static_cast<uint8_t>(local) };
+    }
+    if (const auto upvalue = resolveCapture(name.lexeme, depth); upvalue != -1) {
+        return { VarKind::UPVALUE, static_cast<uint8_t>(upvalue) };
+    }
+    error(name, "Unable to resolve variable.");
+    return { VarKind::GLOBAL, identifierConstant(name.lexeme) };
+}
+
+int32_t SpicyCompiler::resolveLocal(const std::string& name, uint32_t depth) const {
+    if (depth < m_current->baseDepth) return -1;
+    const auto& locals = m_current->locals;
+    for (auto i = static_cast<int32_t>(locals.size()) - 1; i >= 0; --i) {
+        if (locals[i].depth == depth && locals[i].name == name) {
+            return i;
         }
-        if (name.lexeme == local.name.lexeme) {
-            error(std::format("Variable [{}] is alread defined in this scope.", name.lexeme));
+    }
+    return -1;
+}
+
+int32_t SpicyCompiler::resolveCapture(const std::string& name, uint32_t depth) const {
+    const auto& captures = m_current->captures;
+    for (auto i = 0u; i < captures.size(); ++i) {
+        if (captures[i].depth == depth && captures[i].name == name) {
+            return static_cast<int32_t>(i);
         }
     }
-    addLocal(name);
+    return -1;
 }
 
-void SpicyCompiler::defineVariable(uint8_t global) {
-    if (m_scopeDepth > 0) {
-        markInitialized();
-        return;
+void SpicyCompiler::emitGet(const VarRef& ref) {
+    switch (ref.kind) {
+    case VarKind::LOCAL:    emitBytes(Chunk::OpCode::OP_GET_LOCAL, ref.arg); break;
+    case VarKind::UPVALUE:  emitBytes(Chunk::OpCode::OP_GET_UPVALUE, ref.arg); break;
+    case VarKind::GLOBAL:   emitBytes(Chunk::OpCode::OP_GET_GLOBAL, ref.arg); break;
+    }
+}
+
+void SpicyCompiler::emitSet(const VarRef& ref) {
+    switch (ref.kind) {
+    case VarKind::LOCAL:    emitBytes(Chunk::OpCode::OP_SET_LOCAL, ref.arg); break;
+    case VarKind::UPVALUE:  emitBytes(Chunk::OpCode::OP_SET_UPVALUE, ref.arg); break;
+    case VarKind::GLOBAL:   emitBytes(Chunk::OpCode::OP_SET_GLOBAL, ref.arg); break;
     }
-    
-    emitBytes(Chunk::OpCode::OP_DEFINE_GLOBAL, global);
 }
 
-void SpicyCompiler::addLocal(const spicy::Token& name) {
-    m_locals.emplace_back(Local{ .name = name, .depth = -1 });
+void SpicyCompiler::addLocal(const std::string& name) {
+    if (m_current->locals.size() > std::numeric_limits<uint8_t>::max()) {
+        error("Too many local variables in function.");
+        return;
+    }
+    m_current->locals.emplace_back(Local{ .name = name, .depth = m_scopeDepth });
 }
 
 void SpicyCompiler::markInitialized() {
-    m_locals.back().depth = m_scopeDepth;
+    m_current->locals.back().isInitialized = true;
 }
 
-uint32_t SpicyCompiler::resolveLocal(const spicy::Token& name)
-{
-    for (auto i = static_cast<int>(m_locals.size()) - 1; i >= 0; --i) {
-        if (name.lexeme == m_locals[i].name.lexeme) {
-            if (m_locals[i].depth == -1) {
-                error(std::format("Can't read variable [{}] during in its own initializer.", name.lexeme));
-            }
-            return i;
-        }
+void SpicyCompiler::beginScope() {
+    m_scopeDepth++;
+}
+
+void SpicyCompiler::endScope() {
+    m_scopeDepth--;
+    auto& locals = m_current->locals;
+    while (!locals.empty() && locals.back().depth > m_scopeDepth) {
+        emitByte(locals.back().isCaptured ? Chunk::OpCode::OP_CLOSE_UPVALUE : Chunk::OpCode::OP_POP);
+        locals.pop_back();
     }
-    return -1;
 }
 
+// ===============================================================================================================================
+// ERROR FUNCTIONS
+// ===============================================================================================================================
+
+void SpicyCompiler::error(const Token& token, const std::string& msg) {
+    spicy::error(token, msg);
+    m_hadError = true;
+}
+
+void SpicyCompiler::error(const std::string& msg) {
+    spicy::error(m_line, msg);
+    m_hadError = true;
 }
+
+} // namespace spicy
@@ -2,134 +2,155 @@
 #ifndef H_SPICYCOMPILER
 #define H_SPICYCOMPILER
 
-#include <functional>
 #include <map>
-#include <optional>
-#include "spicyscanner.h"
+#include <memory>
+#include <set>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "spicyast.h"
+#include "spicyoptimizer.h"
+#include "spicyresolver.h"
 #include "vmtypes.h"
 
 namespace spicy {
 
-enum class Precedence {
-    PREC_NONE = 0,
-    PREC_ASSIGNMENT, // =
-    PREC_OR,         // or
-    PREC_AND,        // and
-    PREC_EQUALITY,   // == !=
-    PREC_COMPARISON, // < > <= >=
-    PREC_APPEND,     // <- ->
-    PREC_TERM,       // + -
-    PREC_FACTOR,     // * /
-    PREC_UNARY,      // ! -
-    PREC_CALL,       // . () []
-    PREC_PRIMARY
+struct Local {
+    std::string name;
+    uint32_t depth;
+    bool isInitialized = false;
+    bool isCaptured = false;
 };
 
-using ParseFn = std::optional<std::function<void(bool)>>;
-struct ParseRule {
-    ParseFn prefix;
-    ParseFn infix;
-    Precedence precedence = Precedence::PREC_NONE;
+// a variable a function uses from one of the functions around it, the resolver tells us which scope it's in
+struct Capture {
+    std::string name;
+    uint32_t depth;
 };
 
-struct Local {
-    Token name;
-    int32_t depth;
+// compilation state of the function currently being emitted
+struct FunctionState {
+    Chunk* chunk = nullptr;
+    FuncType type = FuncType::SCRIPT;
+    uint32_t baseDepth = 0; // scope depth of the function's parameters
+    std::vector<Local> locals;
+    std::vector<Capture> captures; // upvalue i holds captures[i]
+    std::map<std::string, uint8_t> identifiers;
 };
 
+// how much of the program ended up being compiled, function bodies are only compiled on their first call
+struct CompileStats {
+    size_t functions = 0;
+    size_t compiledBodies = 0;
+};
+
+/*
+ * Bytecode compiler, walks the AST once it has been through the resolver.
+ * The resolver tells us how many scopes separate a variable from its declaration, since the compiler opens
+ * and closes scopes at the exact same places, that's enough to know if a name is a global, one of our
+ * locals or something we need to capture from an enclosing function.
+ * Constant arithmetic is folded on the way, and loops get their invariant expressions hoisted into hidden
+ * locals (see spicyoptimizer.h).
+ *
+ * Function bodies are compiled lazily: declaring one only emits its closure, the captures it needs are found
+ * by scanning the body, and the body itself is compiled by the vm the first time the function is called.
+ */
 class SpicyCompiler {
-    
 public:
-    explicit SpicyCompiler(SpicyScanner scanner);
-    
-    [[nodiscard]] 
-    auto compile() -> Func;
-    
+    SpicyCompiler(const eval::ResolvedLocals& resolvedLocals, std::shared_ptr<CompileStats> stats);
+
+    [[nodiscard]]
+    auto compile(std::span<const ast::StmtPtrVariant> program) -> Func;
+    [[nodiscard]]
+    auto hadError() const -> bool;
+
 private:
-    void advance();
-    void consume(TokenType type, const std::string& errMsg);
-    bool match(TokenType type);
-    bool check(TokenType type);
+    // statements
+    void compileStmt(const ast::StmtPtrVariant& stmt);
+    void compileStmts(const std::vector<ast::StmtPtrVariant>& stmts);
+    void compileExprStmt(const ast::ExprStmtPtr& stmt);
+    void compilePrintStmt(const ast::PrintStmtPtr& stmt);
+    void compileBlockStmt(const ast::BlockStmtPtr& stmt);
+    void compileVarStmt(const ast::VarStmtPtr& stmt);
+    void compileIfStmt(const ast::IfStmtPtr& stmt);
+    void compileWhileStmt(const ast::WhileStmtPtr& stmt);
+    void compileFuncStmt(const ast::FuncStmtPtr& stmt);
+    void compileRetStmt(const ast::RetStmtPtr& stmt);
+    void compileClassStmt(const ast::ClassStmtPtr& stmt);
+
+    // expressions
+    void compileExpr(const ast::ExprPtrVariant& expr);
+    void compileBinaryExpr(const ast::BinaryExprPtr& expr);
+    void compileGroupingExpr(const ast::GroupingExprPtr& expr);
+    void compileLiteralExpr(const ast::LiteralExprPtr& expr);
+    void compileUnaryExpr(const ast::UnaryExprPtr& expr);
+    void compilePostfixExpr(const ast::PostfixExprPtr& expr);
+    void compileVariableExpr(const ast::VariableExprPtr& expr);
+    void compileAssignExpr(const ast::AssignExprPtr& expr);
+    void compileLogicalExpr(const ast::LogicalExprPtr& expr);
+    void compileCallExpr(const ast::CallExprPtr& expr);
+    void compileFuncExpr(const ast::FuncExprPtr& expr);
+    void compileIndexGetExpr(const ast::IndexGetExprPtr& expr);
+    void compileIndexSetExpr(const ast::IndexSetExprPtr& expr);
+    void unsupported(const Token& token, const std::string& what);
+
+    // loops
+    void hoist(const std::vector<const ast::ExprPtrVariant*>& exprs);
+    void unhoist(const std::vector<const ast::ExprPtrVariant*>& exprs);
 
+    // functions
+    void compileFunction(const ast::FuncExprPtr& decl, const std::string& name);
+    [[nodiscard]]
+    auto compileBody(const ast::FuncExprPtr& decl, uint32_t baseDepth, std::vector<Capture> captures, Chunk& chunk) -> bool;
+    [[nodiscard]]
+    auto findCaptures(const ast::FuncExprPtr& decl, uint32_t baseDepth) const -> std::vector<Capture>;
+
+    // bytecode generation
     void emitByte(uint8_t byte);
     void emitByte(Chunk::OpCode byte);
-    void emitBytes(uint8_t byte1, uint8_t byte2);
     void emitBytes(Chunk::OpCode byte1, uint8_t byte2);
     void emitBytes(Chunk::OpCode byte1, Chunk::OpCode byte2);
-    void emitReturn();
     void emitConstant(SpicyObj constant);
-    void emitLoop(uint32_t loopStart);
-    uint16_t emitJump(Chunk::OpCode byte);
-    
-    void patchJump(uint16_t offset);
-
+    void emitLoop(size_t loopStart);
+    [[nodiscard]] size_t emitJump(Chunk::OpCode byte);
+    void patchJump(size_t offset);
     [[nodiscard]] uint8_t makeConstant(SpicyObj constant);
-    
-    void error(const std::string& msg);
-    void errorAtCurrent(const std::string& msg);
-    void errorAt(const Token& token, const std::string& msg);
-    void synchronize();
-    
-    void parsePrecedence(Precedence prec);
-    
-    void declaration();
-    void varDeclaration();
-    void statement();
-    void block();
-    void printStatement();
-    void ifStatement();
-    void whileStatement();
-    void forStatement();
-    void expressionStatement();
-    
-    void expression();
-    void variable(bool canAssign);
-    void namedVariable(const spicy::Token& name, bool canAssign);
-    void number();
-    void literal();
-    void grouping();
-    void unary();
-    void binary();
-    void string();
-    void and_();
-    void or_();
-    void noop();
-    
+    [[nodiscard]] uint8_t identifierConstant(const std::string& name);
+
+    // variables
+    enum class VarKind { LOCAL, UPVALUE, GLOBAL };
+    struct VarRef {
+        VarKind kind;
+        uint8_t arg;
+    };
+    [[nodiscard]] VarRef resolveVariable(ast::NodeId id, const Token& name);
+    [[nodiscard]] int32_t resolveLocal(const std::string& name, uint32_t depth) const;
+    [[nodiscard]] int32_t resolveCapture(const std::string& name, uint32_t depth) const;
+    void emitGet(const VarRef& ref);
+    void emitSet(const VarRef& ref);
+    void addLocal(const std::string& name);
+    void markInitialized();
     void beginScope();
     void endScope();
-    
-    [[nodiscard]] 
-    uint8_t parseVar(const std::string& errMsg);
-    [[nodiscard]] 
-    uint8_t identifierConst(const spicy::Token& name);
-    void declareVariable();
-    void defineVariable(uint8_t global);
-    void addLocal(const spicy::Token& name);
-    void markInitialized();
-    uint32_t resolveLocal(const spicy::Token& name);
-    
-private: 
-    // Scanner and output
-    SpicyScanner m_scanner;
-    Chunk m_chunk;
-
-    // Parser;
-    Token m_previous;
-    Token m_current;
-    std::map<TokenType, ParseRule> m_rules;
-    
-    // Current function for handling top-level and function calls
-    Func m_function;
-    FuncType m_funcType = FuncType::SCRIPT;
-    
-    // Scoping
-    std::vector<Local> m_locals;
+
+    void error(const Token& token, const std::string& msg);
+    void error(const std::string& msg);
+
+private:
+    const eval::ResolvedLocals& m_resolvedLocals;
+    std::shared_ptr<CompileStats> m_stats;
+    std::shared_ptr<const std::set<std::string>> m_userGlobals;
+    opt::HoistedExprs m_hoisted;
+    FunctionState* m_current = nullptr;
     uint32_t m_scopeDepth = 0u;
-    
-    // Util
+    int m_line = 0;
     bool m_hadError = false;
-    bool m_panicMode = false;
+
+    friend struct SpicyStmtCompiler;
+    friend struct SpicyExprCompiler;
 };
-} // namespace spicy;
 
-#endif H_SPICYCOMPILER
+} // namespace spicy
+
+#endif // H_SPICYCOMPILER
@@ -1,50 +1,28 @@
 #include "spicyenvironment.h"
 
-#include "spicy.h"
+#include "spicylog.h"
 
 namespace spicy::eval {
 
-namespace {
-class UndefinedVarAccess : public std::exception {};
-class UninitializedVarAccess : public std::exception {};
-}
-
 /*
  * Environement
  */
 Environment::Environment(EnvironmentPtr parent)
     : m_parent(std::move(parent)) {}
 
-bool Environment::assign(size_t hashedVarName, SpicyObj object) {
-    if (const auto& iter = m_objects.find(hashedVarName);
-        iter != m_objects.end()) {
-        m_objects.insert_or_assign(hashedVarName, object);
-        return true;
-    }
-    if (m_parent != nullptr) {
-        m_parent->assign(hashedVarName, std::move(object));
-    }
-    throw UndefinedVarAccess{};
+void Environment::assign(uint32_t slot, SpicyObj object) {
+    m_slots[slot] = std::move(object);
 }
 
-void Environment::define(size_t hashedVarName, SpicyObj object) {
-    m_objects.insert_or_assign(hashedVarName, object);
+void Environment::define(SpicyObj object) {
+    m_slots.emplace_back(std::move(object));
 }
 
-SpicyObj Environment::get(size_t hashedVarName) {
-    if (const auto& iter = m_objects.find(hashedVarName);
-        iter != m_objects.end()) {
-        const auto& val = iter->second;
-        if (std::holds_alternative<std::nullptr_t>(val))
-            throw UninitializedVarAccess{};
-        return val;
-    }
-    if (m_parent != nullptr)
-        return m_parent->get(hashedVarName);
-    throw UndefinedVarAccess{};
+const SpicyObj& Environment::get(uint32_t slot) const {
+    return m_slots[slot];
 }
 
-Environment::EnvironmentPtr Environment::getParent() {
+const Environment::EnvironmentPtr& Environment::getParent() const {
     return m_parent;
 }
 
@@ -52,110 +30,154 @@ bool Environment::isGlobal() {
     return m_parent != nullptr;
 }
 
+/*
+ * EnvironmentPool
+ */
+template <typename T>
+struct EnvironmentPool::BlockAllocator {
+    using value_type = T;
+    EnvironmentPool* pool;
+
+    explicit BlockAllocator(EnvironmentPool* pool) : pool(pool) {}
+    template <typename U>
+    BlockAllocator(const BlockAllocator<U>& other) : pool(other.pool) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(pool->allocateBlock(n * sizeof(T))); }
+    void deallocate(T* block, size_t n) { pool->deallocateBlock(block, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const BlockAllocator<U>& other) const { return pool == other.pool; }
+};
+
+struct EnvironmentPool::Recycler {
+    EnvironmentPool* pool;
+    void operator()(Environment* env) const { pool->release(env); }
+};
+
+EnvironmentPool::~EnvironmentPool() {
+    for (auto* env : m_freeEnvs)
+        delete env;
+    for (auto* block : m_freeBlocks)
+        ::operator delete(block);
+}
+
+Environment::EnvironmentPtr EnvironmentPool::acquire(Environment::EnvironmentPtr parent) {
+    auto* env = [&]() {
+        if (m_freeEnvs.empty())
+            return new Environment(std::move(parent));
+        auto* recycled = m_freeEnvs.back();
+        m_freeEnvs.pop_back();
+        recycled->m_parent = std::move(parent);
+        return recycled;
+    }();
+    return Environment::EnvironmentPtr(env, Recycler{ this }, BlockAllocator<Environment>{ this });
+}
+
+void EnvironmentPool::release(Environment* env) {
+    // this can release more environments (a dead closure in a slot, the parent), they go on the list first
+    SPICY_LOG(log::Category::Gc, "recycling environment {} ({} slots)", static_cast<const void*>(env), env->m_slots.size());
+    env->m_slots.clear();
+    env->m_parent.reset();
+    m_freeEnvs.push_back(env);
+}
+
+// shared_ptr only ever asks for its control block, which is always the same size
+void* EnvironmentPool::allocateBlock(size_t size) {
+    if (m_blockSize == 0)
+        m_blockSize = size;
+    if (size != m_blockSize || m_freeBlocks.empty())
+        return ::operator new(size);
+    auto* block = m_freeBlocks.back();
+    m_freeBlocks.pop_back();
+    return block;
+}
+
+void EnvironmentPool::deallocateBlock(void* block, size_t size) {
+    if (size != m_blockSize) {
+        ::operator delete(block);
+        return;
+    }
+    m_freeBlocks.push_back(block);
+}
+
 /*
  * EnvironmentMgr
  */
 EnvironmentMgr::EnvironmentMgr()
     : m_current(std::make_shared<Environment>(nullptr)) {
     m_global = m_current;
-    dbgPrint("EnvironmentMgr constructed! Global env = "
-             + std::to_string(reinterpret_cast<uint64_t>(m_current.get())));
+    SPICY_LOG(log::Category::Environment, "global environment: {}", static_cast<const void*>(m_global.get()));
 }
 
-void EnvironmentMgr::assign(const Token &token, SpicyObj object) {
-    try {
-        m_current->assign(m_hasher(token.lexeme), std::move(object));
-    }  catch (const UndefinedVarAccess& e) {
-        throw RuntimeError(token, "Undefined variable.");
-    }
-}
-
-void EnvironmentMgr::assignAt(uint32_t distance, const Token &token, SpicyObj object) {
-    ancestor(distance)->assign(m_hasher(token.lexeme), std::move(object));
+void EnvironmentMgr::assignAt(uint32_t distance, uint32_t slot, SpicyObj object) {
+    ancestor(distance)->assign(slot, std::move(object));
 }
 
 void EnvironmentMgr::assignGlobal(const Token &token, SpicyObj object) {
-    assignGlobal(token.lexeme, object);
-}
-
-void EnvironmentMgr::assignGlobal(const std::string &name, SpicyObj object) {
-    m_global->assign(m_hasher(name), std::move(object));
+    const auto global = m_globals.find(m_hasher(token.lexeme));
+    if (global == m_globals.end())
+        throw RuntimeError(token, "Undefined variable.");
+    global->second = std::move(object);
 }
 
-void EnvironmentMgr::createNewEnvironment(const std::string &caller) {
-    m_current = std::make_shared<Environment>(m_current);
-    dbgPrint(caller + " requested new environement: " + std::to_string(reinterpret_cast<uint64_t>(m_current.get())));
+void EnvironmentMgr::createNewEnvironment(std::string_view caller) {
+    m_current = m_pool.acquire(std::move(m_current));
+    SPICY_LOG(log::Category::Environment, "{} created environment {}", caller, static_cast<const void*>(m_current.get()));
 }
 
-void EnvironmentMgr::discardEnvironmentsUntil(const Environment::EnvironmentPtr &toRestore, const std::string &caller) {
-    dbgPrint("discarding environements until: "
-             + std::to_string(reinterpret_cast<uint64_t>(toRestore.get()))
-             + "\ncaller: " + caller
-             + "\ncurrent env:"
-             + std::to_string(reinterpret_cast<uint64_t>(m_current.get())));
-    while (!m_current->isGlobal()
-           && m_current.get() != toRestore.get()) {
-        dbgPrint("discarding env: " + std::to_string(reinterpret_cast<uint64_t>(m_current.get())));
-        m_current = m_current->getParent();
-    }
+// makes an environment without switching to it, a call fills it with its arguments first
+Environment::EnvironmentPtr EnvironmentMgr::newEnvironment(Environment::EnvironmentPtr parent, std::string_view caller) {
+    auto env = m_pool.acquire(std::move(parent));
+    SPICY_LOG(log::Category::Environment, "{} created environment {}", caller, static_cast<const void*>(env.get()));
+    return env;
 }
 
 void EnvironmentMgr::define(const std::string &tokenStr, SpicyObj object) {
-    m_current->define(m_hasher(tokenStr), std::move(object));
+    if (m_current == m_global)
+        m_globals.insert_or_assign(m_hasher(tokenStr), std::move(object));
+    else
+        m_current->define(std::move(object));
 }
 
 void EnvironmentMgr::define(const Token &token, SpicyObj object) {
-    m_current->define(m_hasher(token.lexeme), std::move(object));
+    define(token.lexeme, std::move(object));
 }
 
 void EnvironmentMgr::defineGlobal(const std::string &tokenStr, SpicyObj object) {
-    m_global->define(m_hasher(tokenStr), std::move(object));
+    m_globals.insert_or_assign(m_hasher(tokenStr), std::move(object));
 }
 
-SpicyObj EnvironmentMgr::get(const Token &token) {
-    try {
-        return m_current->get(m_hasher(token.lexeme));
-    } catch (const UndefinedVarAccess& ex) {
-        throw RuntimeError(token, "Undefined variable.");
-    } catch (const UninitializedVarAccess& ex) {
-        throw RuntimeError(token, "Uninitialized variable.");
-    }
+void EnvironmentMgr::defineLocal(SpicyObj object) {
+    m_current->define(std::move(object));
 }
 
-SpicyObj EnvironmentMgr::get(uint32_t distance, const Token &token) {
-    return ancestor(distance)->get(m_hasher(token.lexeme));
-}
-
-SpicyObj EnvironmentMgr::get(uint32_t distance, const std::string &token) {
-    return ancestor(distance)->get(m_hasher(token));
+const SpicyObj& EnvironmentMgr::get(uint32_t distance, uint32_t slot) const {
+    return ancestor(distance)->get(slot);
 }
 
 SpicyObj EnvironmentMgr::getGlobal(const Token &token) {
-    try {
-        return m_global->get(m_hasher(token.lexeme));
-    } catch (const UndefinedVarAccess& ex) {
+    const auto global = m_globals.find(m_hasher(token.lexeme));
+    if (global == m_globals.end())
         throw RuntimeError(token, "Undefined variable.");
-    } catch (const UninitializedVarAccess& ex) {
+    if (global->second.is<std::nullptr_t>())
         throw RuntimeError(token, "Uninitialized variable.");
-    }
+    return global->second;
 }
 
 Environment::EnvironmentPtr EnvironmentMgr::getCurrentEnvironment() {
     return m_current;
 }
 
-void EnvironmentMgr::setCurrentEnvironment(Environment::EnvironmentPtr newCurrent, const std::string &caller) {
-    dbgPrint(caller + " requested setting current env to: "
-             + std::to_string(reinterpret_cast<uint64_t>(newCurrent.get()))
-             + "\ncurrent env: "
-             + std::to_string(reinterpret_cast<uint64_t>(m_current.get())));
+void EnvironmentMgr::setCurrentEnvironment(Environment::EnvironmentPtr newCurrent, std::string_view caller) {
+    SPICY_LOG(log::Category::Environment, "{} switched environment {} -> {}",
+              caller, static_cast<const void*>(m_current.get()), static_cast<const void*>(newCurrent.get()));
     m_current = std::move(newCurrent);
 }
 
-Environment::EnvironmentPtr EnvironmentMgr::ancestor(uint32_t distance) {
-    auto env = m_current;
-    for (auto i = 0; i < distance; ++i) {
-        env = env->getParent();
+Environment* EnvironmentMgr::ancestor(uint32_t distance) const {
+    auto env = m_current.get();
+    for (auto i = 0u; i < distance; ++i) {
+        env = env->getParent().get();
     }
     return env;
 }
@@ -8,6 +8,8 @@
 #include <map>
 #include <memory>
 #include <optional>
+#include <string_view>
+#include <vector>
 
 #include "spicyutil.h"
 #include "spicyobjects.h"
@@ -15,50 +17,79 @@
 
 namespace spicy::eval {
 
+class EnvironmentPool;
+
+// Locals live in slots, the resolver numbers them in declaration order so that a lookup is a walk up the
+// parents followed by an index. Globals aren't resolved, they stay in the manager and are looked up by name.
 class Environment : public util::Uncopyable,
                     std::enable_shared_from_this<Environment> {
 public:
     using EnvironmentPtr = std::shared_ptr<Environment>;
     explicit Environment(EnvironmentPtr parent = nullptr);
 
-    bool assign(size_t hashedVarName, SpicyObj object);
-    void define(size_t hashedVarName, SpicyObj object);
-    SpicyObj get(size_t hashedVarName);
-    EnvironmentPtr getParent();
+    void assign(uint32_t slot, SpicyObj object);
+    void define(SpicyObj object);
+    const SpicyObj& get(uint32_t slot) const;
+    const EnvironmentPtr& getParent() const;
     bool isGlobal();
 private:
-    std::map<size_t, SpicyObj> m_objects;
+    std::vector<SpicyObj> m_slots;
     EnvironmentPtr m_parent = nullptr;
+
+    friend class EnvironmentPool;
+};
+
+// Hands out environments for blocks and calls and takes them back once nothing refers to them anymore, which is
+// right away unless a closure captured them. Recycled environments keep the capacity of their slots and the
+// shared_ptr control blocks are recycled too, so entering a block or a function doesn't hit the allocator once
+// the pool is warm. Environments still point back at their pool when released: it must outlive all of them.
+class EnvironmentPool : public util::Uncopyable {
+    template <typename T>
+    struct BlockAllocator;
+    struct Recycler;
+
+    std::vector<Environment*> m_freeEnvs;
+    std::vector<void*> m_freeBlocks;
+    size_t m_blockSize = 0;
+
+public:
+    EnvironmentPool() = default;
+    ~EnvironmentPool();
+
+    [[nodiscard]] Environment::EnvironmentPtr acquire(Environment::EnvironmentPtr parent);
+
+private:
+    void release(Environment* env);
+    void* allocateBlock(size_t size);
+    void deallocateBlock(void* block, size_t size);
 };
 
 class EnvironmentMgr : public util::Uncopyable {
+    EnvironmentPool m_pool;     // first, so that it's destroyed after every environment it handed out
     Environment::EnvironmentPtr m_global;
     Environment::EnvironmentPtr m_current;
+    std::map<size_t, SpicyObj> m_globals;
     std::hash<std::string> m_hasher;
 
 public:
     EnvironmentMgr();
 
-    void assign(const Token& token, SpicyObj object);
-    void assignAt(uint32_t distance, const Token& token, SpicyObj object);
+    void assignAt(uint32_t distance, uint32_t slot, SpicyObj object);
     void assignGlobal(const Token& token, SpicyObj object);
-    void assignGlobal(const std::string& name, SpicyObj object);
-    void createNewEnvironment(const std::string& caller);
-    void discardEnvironmentsUntil(const Environment::EnvironmentPtr& toRestore,
-                                  const std::string& caller);
+    void createNewEnvironment(std::string_view caller);
+    [[nodiscard]] Environment::EnvironmentPtr newEnvironment(Environment::EnvironmentPtr parent, std::string_view caller);
     void define(const std::string& tokenStr, SpicyObj object);
     void define(const Token& token, SpicyObj object);
     void defineGlobal(const std::string& tokenStr, SpicyObj object);
-    SpicyObj get(const Token& token);
-    SpicyObj get(uint32_t distance, const Token& token);
-    SpicyObj get(uint32_t distance, const std::string& token);
+    void defineLocal(SpicyObj object);
+    const SpicyObj& get(uint32_t distance, uint32_t slot) const;
     SpicyObj getGlobal(const Token& token);
     Environment::EnvironmentPtr getCurrentEnvironment();
     void setCurrentEnvironment(Environment::EnvironmentPtr newCurrent,
-                               const std::string& caller);
+                               std::string_view caller);
 
 private:
-    Environment::EnvironmentPtr ancestor(uint32_t distance);
+    Environment* ancestor(uint32_t distance) const;
 };
 
 } // namespace spicy::eval
@@ -7,71 +7,68 @@
 
 #include "spicy.h"
 #include "spicybuiltins.h"
+#include "spicylog.h"
 
 namespace spicy::eval {
 
 namespace typecheck {
 void checkUnaryNumOperand(Token op, const SpicyObj& rhs) {
-    if (std::holds_alternative<double>(rhs)) return;
+    if (numbers::isNumber(rhs)) return;
     throw RuntimeError(op, "Operand must be a number.");
 }
 
 void checkBinaryNumOperands(Token op, const SpicyObj& lhs, const SpicyObj& rhs) {
-    if (std::holds_alternative<double>(lhs) && std::holds_alternative<double>(rhs)) return;
+    if (numbers::isNumber(lhs) && numbers::isNumber(rhs)) return;
     throw RuntimeError(op, "Operands must be numbers.");
 }
 
 void checkPlusOperands(Token op, const SpicyObj& lhs, const SpicyObj& rhs) {
-    if (std::holds_alternative<double>(lhs) && std::holds_alternative<double>(rhs)) return;
-    if (std::holds_alternative<std::string>(lhs) && std::holds_alternative<std::string>(rhs)) return;
+    if (numbers::isNumber(lhs) && numbers::isNumber(rhs)) return;
+    if (lhs.is<std::string>() && rhs.is<std::string>()) return;
     throw RuntimeError(op, "Operands must be numbers or strings.");
 }
 
 void checkAppendOperands(Token op, const SpicyObj& lhs, const SpicyObj& rhs) {
     if (op.type == TokenType::ARROW) {
-        if (!std::holds_alternative<SpicyListSharedPtr>(lhs))
+        if (!lhs.is<SpicyListSharedPtr>())
             throw RuntimeError(op, "Can only append elements to lists.");
     }
     else if (op.type == TokenType::RARROW) {
-        if (!std::holds_alternative<SpicyListSharedPtr>(rhs))
+        if (!rhs.is<SpicyListSharedPtr>())
             throw RuntimeError(op, "Can only append elements to lists.");
     }
 }
 
 void checkPipeOperands(Token op, const SpicyObj& lhs, const SpicyObj& rhs)
 {
-    if (!std::holds_alternative<FuncSharedPtr>(lhs))
+    if (!lhs.is<FuncSharedPtr>())
         throw RuntimeError(op, "Left hand side of chain operation isn't a function.");
     
-    if (!std::holds_alternative<FuncSharedPtr>(rhs))
+    if (!rhs.is<FuncSharedPtr>())
         throw RuntimeError(op, "Right hand side of chain operation isn't a function.");
 }
 }
 
 namespace internal {
-SpicyObj getObjFromStringLit(const TokenLiteral& lit) {
-    const auto& str = std::get<std::string>(lit);
-    if (str == "true") return SpicyObj{true};
-    if (str == "false") return SpicyObj{false};
-    if (str == "nil") return SpicyObj{nullptr};
-    if (str == "<spicy_list>") return std::make_shared<SpicyList>();
-    return SpicyObj{str};
-}
 /*
  * the plus operator is a tiny bit complicated
  */
 SpicyObj evalPlusBinOp(const SpicyObj& lval, const SpicyObj& rval) {
-    if (std::holds_alternative<double>(lval) && std::holds_alternative<double>(rval)) {
-        return std::get<double>(lval) + std::get<double>(rval);
+    if (lval.is<double>() && rval.is<double>()) {
+        return lval.as<double>() + rval.as<double>();
+    }
+    if (numbers::isNumber(lval) && numbers::isNumber(rval)) {
+        return numbers::add(lval, rval);
     }
-    if (std::holds_alternative<std::string>(lval) && std::holds_alternative<std::string>(rval)) {
-        return std::get<std::string>(lval) + std::get<std::string>(rval);
+    if (lval.is<std::string>() && rval.is<std::string>()) {
+        return StringObj::concat(lval.as<StringSharedPtr>(), rval.as<StringSharedPtr>());
     }
     return SpicyObj{nullptr};
 }
 } // namespace internal
 
-SpicyEvaluator::SpicyEvaluator(bool isRepl) : m_isRepl(isRepl) {
+SpicyEvaluator::SpicyEvaluator(const ResolvedLocals& locals, bool isRepl)
+    : m_locals(locals), m_isRepl(isRepl) {
     initBuiltins();
 }
 
@@ -98,18 +95,12 @@ struct SpicyExprEvaluator {
 };
 
 SpicyObj SpicyEvaluator::evalExpr(const ast::ExprPtrVariant& expr) {
-    m_lastObj = std::move(std::visit(SpicyExprEvaluator(this), expr));
-    return m_lastObj;
+    return std::visit(SpicyExprEvaluator(this), expr);
 }
 
 SpicyObj SpicyEvaluator::evalLiteralExpr(const ast::LiteralExprPtr& expr) {
-    if (expr->literalVal.has_value()) {
-        const auto& val = expr->literalVal.value();
-        return std::holds_alternative<std::string>(val)
-                ? internal::getObjFromStringLit(val)
-                : SpicyObj{std::get<double>(val)};
-    }
-    return SpicyObj{nullptr};
+    if (expr->isList) return makeRef<SpicyList>();
+    return expr->value;
 }
 
 SpicyObj SpicyEvaluator::evalGroupingExpr(const ast::GroupingExprPtr& expr) {
@@ -121,7 +112,7 @@ SpicyObj SpicyEvaluator::evalUnaryExpr(const ast::UnaryExprPtr& expr) {
     switch (expr->op.type) {
     case TokenType::MINUS:
         typecheck::checkUnaryNumOperand(expr->op, rval);
-        return -std::get<double>(rval);
+        return numbers::negate(rval);
     case TokenType::BANG:
         return !isTrue(rval);
     case TokenType::PLUS_PLUS:
@@ -131,10 +122,10 @@ SpicyObj SpicyEvaluator::evalUnaryExpr(const ast::UnaryExprPtr& expr) {
             throw RuntimeError(expr->op, "Operand must be a variable.");
         typecheck::checkUnaryNumOperand(expr->op, rval);
         const auto& varExpr = std::get<ast::VariableExprPtr>(expr->right);
-        const auto value = expr->op.type == TokenType::PLUS_PLUS ? ++std::get<double>(rval) : --std::get<double>(rval);
-        if (const auto& distance = m_locals.find(reinterpret_cast<uint64_t>(varExpr.get()));
-            distance != m_locals.end()) {
-            m_envMgr.assignAt(distance->second, varExpr->varName, value);
+        const auto value = expr->op.type == TokenType::PLUS_PLUS ? numbers::add(rval, int64_t{1})
+                                                                 : numbers::subtract(rval, int64_t{1});
+        if (const auto local = m_locals.find(varExpr->id); local.has_value()) {
+            m_envMgr.assignAt(local->distance, local->slot, value);
         } else {
             m_envMgr.assignGlobal(varExpr->varName, value);
         }
@@ -154,15 +145,14 @@ SpicyObj SpicyEvaluator::evalPostfixExpr(const ast::PostfixExprPtr& expr) {
     const auto& lval = evalExpr(expr->left);
     typecheck::checkUnaryNumOperand(expr->op, lval);
     const auto& varExpr = std::get<ast::VariableExprPtr>(expr->left);
-    const auto& ret = std::get<double>(lval);
-    const auto value = expr->op.type == TokenType::PLUS_PLUS ? ret + 1 : ret - 1;
-    if (const auto& distance = m_locals.find(reinterpret_cast<uint64_t>(varExpr.get()));
-        distance != m_locals.end()) {
-        m_envMgr.assignAt(distance->second, varExpr->varName, value);
+    const auto value = expr->op.type == TokenType::PLUS_PLUS ? numbers::add(lval, int64_t{1})
+                                                             : numbers::subtract(lval, int64_t{1});
+    if (const auto local = m_locals.find(varExpr->id); local.has_value()) {
+        m_envMgr.assignAt(local->distance, local->slot, value);
     } else {
         m_envMgr.assignGlobal(varExpr->varName, value);
     }
-    return ret;
+    return lval;
 }
 
 SpicyObj SpicyEvaluator::evalBinaryExpr(const ast::BinaryExprPtr &expr) {
@@ -174,44 +164,44 @@ SpicyObj SpicyEvaluator::evalBinaryExpr(const ast::BinaryExprPtr &expr) {
         return internal::evalPlusBinOp(lval, rval);
     case TokenType::MINUS:
         typecheck::checkBinaryNumOperands(expr->op, lval, rval);
-        return std::get<double>(lval) - std::get<double>(rval);
+        return numbers::subtract(lval, rval);
     case TokenType::SLASH:
         typecheck::checkBinaryNumOperands(expr->op, lval, rval);
-        return std::get<double>(lval) / std::get<double>(rval);
+        return numbers::divide(lval, rval);
     case TokenType::STAR:
         typecheck::checkBinaryNumOperands(expr->op, lval, rval);
-        return std::get<double>(lval) * std::get<double>(rval);
+        return numbers::multiply(lval, rval);
     case TokenType::GREATER:
         typecheck::checkBinaryNumOperands(expr->op, lval, rval);
-        return std::get<double>(lval) > std::get<double>(rval);
+        return numbers::compare<std::greater<>>(lval, rval);
     case TokenType::GREATER_EQUAL:
         typecheck::checkBinaryNumOperands(expr->op, lval, rval);
-        return std::get<double>(lval) >= std::get<double>(rval);
+        return numbers::compare<std::greater_equal<>>(lval, rval);
     case TokenType::LESS:
         typecheck::checkBinaryNumOperands(expr->op, lval, rval);
-        return std::get<double>(lval) < std::get<double>(rval);
+        return numbers::compare<std::less<>>(lval, rval);
     case TokenType::LESS_EQUAL:
         typecheck::checkBinaryNumOperands(expr->op, lval, rval);
-        return std::get<double>(lval) <= std::get<double>(rval);
+        return numbers::compare<std::less_equal<>>(lval, rval);
     case TokenType::BANG_EQUAL:
         return !areEqual(lval, rval);
     case TokenType::EQUAL_EQUAL:
         return areEqual(lval, rval);
     case TokenType::ARROW: {
             typecheck::checkAppendOperands(expr->op, lval, rval);
-            auto lst = std::get<SpicyListSharedPtr>(lval);
+            auto lst = lval.as<SpicyListSharedPtr>();
             lst->append(expr->op, rval);
             return lst;
         }
     case TokenType::RARROW: {
             typecheck::checkAppendOperands(expr->op, lval, rval);
-            auto lst = std::get<SpicyListSharedPtr>(rval);
+            auto lst = rval.as<SpicyListSharedPtr>();
             lst->appendFront(expr->op, lval);
             return lst;
         }
     //case TokenType::PIPE: {
     //    typecheck::checkPipeOperands(expr->op, lval, rval);
-    //    return std::make_shared<FuncObj>();
+    //    return makeRef<FuncObj>();
     //}
     default:
         throw RuntimeError(expr->op, "Unexpected operator in binary expression.");
@@ -220,14 +210,13 @@ SpicyObj SpicyEvaluator::evalBinaryExpr(const ast::BinaryExprPtr &expr) {
 }
 
 SpicyObj SpicyEvaluator::evalVariableExpr(const ast::VariableExprPtr &expr) {
-    return lookUpVariable(expr->varName, reinterpret_cast<uint64_t>(expr.get()));
+    return lookUpVariable(expr->varName, expr->id);
 }
 
 SpicyObj SpicyEvaluator::evalAssignExpr(const ast::AssignExprPtr &expr) {
     auto value = evalExpr(expr->right);
-    if (const auto& distance = m_locals.find(reinterpret_cast<uint64_t>(expr.get()));
-        distance != m_locals.end()) {
-        m_envMgr.assignAt(distance->second, expr->varName, value);
+    if (const auto local = m_locals.find(expr->id); local.has_value()) {
+        m_envMgr.assignAt(local->distance, local->slot, value);
     } else {
         m_envMgr.assignGlobal(expr->varName, value);
     }
@@ -235,7 +224,7 @@ SpicyObj SpicyEvaluator::evalAssignExpr(const ast::AssignExprPtr &expr) {
 }
 
 SpicyObj SpicyEvaluator::evalLogicalExpr(const ast::LogicalExprPtr &expr) {
-    const auto& lhs = evalExpr(expr->left);
+    auto lhs = evalExpr(expr->left);
     if (expr->op.type == TokenType::OR) {
         if (isTrue(lhs)) return lhs;
     } else {
@@ -245,136 +234,134 @@ SpicyObj SpicyEvaluator::evalLogicalExpr(const ast::LogicalExprPtr &expr) {
 }
 
 SpicyObj SpicyEvaluator::evalCallExpr(const ast::CallExprPtr &expr) {
-    auto callee = evalExpr(expr->callee);
-
-    if (std::holds_alternative<BuiltinFuncSharedPtr>(callee)) {
-        return evalBuiltInCall(std::get<BuiltinFuncSharedPtr>(callee), expr);
-    }
-
-    auto instanceOrNull = ([&]() -> SpicyObj {
-        if (std::holds_alternative<SpicyClassSharedPtr>(callee))
-            return std::make_shared<SpicyInstance>(
-                        std::get<SpicyClassSharedPtr>(callee));
-        return SpicyObj{nullptr};
-    })();
-
-    const auto func = ([&]() -> FuncSharedPtr {
-        if (std::holds_alternative<SpicyClassSharedPtr>(callee)) {
-            auto instance = std::get<SpicyInstanceSharedPtr>(instanceOrNull);
-            try {
-                return bindInstance(std::get<FuncSharedPtr>(instance->get("init")), instance);
-            } catch (RuntimeError& err) {
-                runtimeError(err);
-                return nullptr;
-            }
-        }
-        if (std::holds_alternative<FuncSharedPtr>(callee))
-            return std::get<FuncSharedPtr>(callee);
-        throw RuntimeError(expr->paren, "Attempted to invoke a non-function.");
-    })();
+    auto [callee, receiver] = evalCallee(expr->callee);
+    return call(callee, std::move(receiver), expr);
+}
 
-    if (func == nullptr)
-        return instanceOrNull;
+// obj.method() never binds the method, the instance it was found on is handed to the call as its receiver instead
+SpicyEvaluator::Callee SpicyEvaluator::evalCallee(const ast::ExprPtrVariant& callee) {
+    if (!std::holds_alternative<ast::GetExprPtr>(callee))
+        return Callee{ evalExpr(callee), nullptr };
 
-    if (expr->arguments.size() != func->arity())
-        throw RuntimeError(expr->paren, std::format("Expected {} argurments but got {}.", func->arity(), expr->arguments.size()));
-
-    std::vector<SpicyObj> args;
-    for (const auto& arg : expr->arguments)
-        args.emplace_back(evalExpr(arg));
+    const auto& expr = std::get<ast::GetExprPtr>(callee);
+    auto obj = evalExpr(expr->object);
+    if (!obj.is<SpicyInstanceSharedPtr>())
+        throw RuntimeError(expr->name, "Only class instances have properties.");
+    auto instance = obj.as<SpicyInstanceSharedPtr>();
+    if (const auto* field = instance->findField(expr->cache.field))
+        return Callee{ *field, nullptr };
+    return Callee{ instance->getMethod(expr->name, expr->cache), std::move(instance) };
+}
 
-    const auto& prevEnv = m_envMgr.getCurrentEnvironment();
-    m_envMgr.setCurrentEnvironment(func->getClosure(), func->getFuncName());
-    m_envMgr.createNewEnvironment(func->getFuncName());
-
-    const auto& params = func->getParams();
-    auto param = params.begin();
-    auto arg = args.begin();
-    for (; param != params.end() && arg != args.end(); ++param, ++arg) {
-        m_envMgr.define(*param, *arg);
+SpicyObj SpicyEvaluator::call(const SpicyObj& callee, SpicyInstanceSharedPtr receiver, const ast::CallExprPtr& expr) {
+    if (callee.is<BuiltinFuncSharedPtr>()) {
+        return evalBuiltInCall(callee.as<BuiltinFuncSharedPtr>(), expr);
     }
 
-    auto ret = execStmts(func->getBodyStmts());
-
-    if (func->isInit())
-        ret = m_envMgr.get(0, "this");
+    if (callee.is<SpicyClassSharedPtr>()) {
+        const auto class_ = callee.as<SpicyClassSharedPtr>();
+        auto instance = makeRef<SpicyInstance>(class_);
+        static const auto initIndex = methodIndex("init");
+        if (const auto* init = class_->lookupMethod(initIndex))
+            call(*init, instance, expr);
+        else if (!expr->arguments.empty())
+            throw RuntimeError(expr->paren, std::format("Expected 0 argurments but got {}.", expr->arguments.size()));
+        return instance;
+    }
 
-    if (!func->isMethod())
-        m_envMgr.discardEnvironmentsUntil(func->getClosure(), func->getFuncName());
-    else
-        m_envMgr.discardEnvironmentsUntil(func->getClosure()->getParent(), func->getFuncName());
+    if (!callee.is<FuncSharedPtr>())
+        throw RuntimeError(expr->paren, "Attempted to invoke a non-function.");
+    const auto func = callee.as<FuncSharedPtr>();
+
+    auto prevEnv = m_envMgr.getCurrentEnvironment();
+    auto ret = OptSpicyObj{};
+    // calls returned from tail position come back here instead of nesting, see execRetStmt
+    for (auto next = TailCall{ func, newFrame(func, std::move(receiver), expr) };;) {
+        const auto* frame = next.frame.get();
+        m_envMgr.setCurrentEnvironment(std::move(next.frame), next.func->getFuncName());
+        ret = execStmts(next.func->getBodyStmts());
+
+        // initializers give back their receiver, the first slot of their frame
+        if (next.func->isInit())
+            ret = frame->get(0);
+
+        if (!m_tailCall.has_value()) break;
+        next = std::move(m_tailCall.value());
+        m_tailCall.reset();
+    }
 
-    m_envMgr.setCurrentEnvironment(prevEnv, func->getFuncName());
+    m_envMgr.setCurrentEnvironment(std::move(prevEnv), func->getFuncName());
 
     if (ret.has_value())
         return ret.value();
 
-    return instanceOrNull;
+    return SpicyObj{nullptr};
 }
 
 SpicyObj SpicyEvaluator::evalGetExpr(const ast::GetExprPtr &expr) {
     const auto& obj = evalExpr(expr->object);
-    if (!std::holds_alternative<SpicyInstanceSharedPtr>(obj)) {
+    if (!obj.is<SpicyInstanceSharedPtr>()) {
         throw RuntimeError(expr->name, "Only class instances have properties.");
     }
-    auto prop = std::get<SpicyInstanceSharedPtr>(obj)->get(expr->name);
-    if (std::holds_alternative<FuncSharedPtr>(prop)) {
-        prop = SpicyObj{bindInstance(std::get<FuncSharedPtr>(prop), std::get<SpicyInstanceSharedPtr>(obj))};
-    }
-    return prop;
+    const auto instance = obj.as<SpicyInstanceSharedPtr>();
+    if (const auto* field = instance->findField(expr->cache.field))
+        return *field;
+    // a method taken as a value remembers the instance it came from
+    return instance->getMethod(expr->name, expr->cache).as<FuncSharedPtr>()->bind(instance);
 }
 
 SpicyObj SpicyEvaluator::evalSetExpr(const ast::SetExprPtr &expr) {
     const auto& obj = evalExpr(expr->object);
-    if (!std::holds_alternative<SpicyInstanceSharedPtr>(obj)) {
+    if (!obj.is<SpicyInstanceSharedPtr>()) {
         throw RuntimeError(expr->name, "Only instances have fields.");
     }
-    const auto& value = evalExpr(expr->value);
-    std::get<SpicyInstanceSharedPtr>(obj)->set(expr->name, value);
+    auto value = evalExpr(expr->value);
+    obj.as<SpicyInstanceSharedPtr>()->set(expr->cache, value);
     return value;
 }
 
 SpicyObj SpicyEvaluator::evalThisExpr(const ast::ThisExprPtr &expr) {
-    return lookUpVariable(expr->keyword, reinterpret_cast<uint64_t>(expr.get()));
+    return lookUpVariable(expr->keyword, expr->id);
 }
 
 SpicyObj SpicyEvaluator::evalSuperExpr(const ast::SuperExprPtr &expr) {
-    const auto distance = m_locals[reinterpret_cast<uint64_t>(expr.get())];
-    const auto superClass = std::get<SpicyClassSharedPtr>(m_envMgr.get(distance, "super"));
-    const auto instance = std::get<SpicyInstanceSharedPtr>(m_envMgr.get(distance - 1, "this"));
-    auto method = superClass->findMethod(expr->method.lexeme);
-    if (!method.has_value())
+    // "super" is alone in the scope enclosing the methods, "this" comes first in the method's own frame
+    const auto distance = m_locals.find(expr->id).value().distance;
+    const auto superClass = m_envMgr.get(distance, 0).as<SpicyClassSharedPtr>();
+    const auto instance = m_envMgr.get(distance - 1, 0).as<SpicyInstanceSharedPtr>();
+    const auto* method = superClass->lookupMethod(expr->index);
+    if (method == nullptr)
         throw RuntimeError(expr->method, std::format("Attempted to access undefined property {} on super.", expr->method.lexeme));
-    return bindInstance(std::get<FuncSharedPtr>(method.value()), instance);
+    return method->as<FuncSharedPtr>()->bind(instance);
 }
 
 SpicyObj SpicyEvaluator::evalFuncExpr(const ast::FuncExprPtr &expr) {
     auto closure = m_envMgr.getCurrentEnvironment();
     // make sure to use a UNIQUE name for lambdas
     //const auto lambdaName = boost::uuids::to_string(expr->uuid);
-    //const auto func = std::make_shared<FuncObj>(expr, "lambda", std::move(closure));
-    return std::make_shared<FuncObj>(expr, "___lambda", std::move(closure));
+    //const auto func = makeRef<FuncObj>(expr, "lambda", std::move(closure));
+    return makeRef<FuncObj>(expr, "___lambda", std::move(closure));
 }
 
 SpicyObj SpicyEvaluator::evalIndexGetExpr(const ast::IndexGetExprPtr& expr) {
     const auto lstObj = evalExpr(expr->lst);
-    if (!std::holds_alternative<SpicyListSharedPtr>(lstObj))
+    if (!lstObj.is<SpicyListSharedPtr>())
         throw RuntimeError(expr->lbracket, "Can only perform indexing operations on lists.");
     const auto idxObj = evalExpr(expr->idx);
-    if (!std::holds_alternative<double>(idxObj))
+    if (!numbers::isNumber(idxObj))
         throw RuntimeError(expr->lbracket, "Index expression must evaluate to a number.");
-    return std::get<SpicyListSharedPtr>(lstObj)->get(expr->lbracket, static_cast<int>(std::get<double>(idxObj)));
+    return lstObj.as<SpicyListSharedPtr>()->get(expr->lbracket, static_cast<int>(numbers::toInteger(idxObj)));
 }
 
 SpicyObj SpicyEvaluator::evalIndexSetExpr(const ast::IndexSetExprPtr& expr) {
-    const auto& lstObj = evalExpr(expr->lst);
-    if (!std::holds_alternative<SpicyListSharedPtr>(lstObj))
+    auto lstObj = evalExpr(expr->lst);
+    if (!lstObj.is<SpicyListSharedPtr>())
         throw RuntimeError(expr->lbracket, "Can only perform indexing operations on lists.");
     const auto idxObj = evalExpr(expr->idx);
-    if (!std::holds_alternative<double>(idxObj))
+    if (!numbers::isNumber(idxObj))
         throw RuntimeError(expr->lbracket, "Index expression must evaluate to a number.");
-    const auto valObj = evalExpr(expr->val);
-    std::get<SpicyListSharedPtr>(lstObj)->set(expr->lbracket, static_cast<int>(std::get<double>(idxObj)), valObj);
+    auto valObj = evalExpr(expr->val);
+    lstObj.as<SpicyListSharedPtr>()->set(expr->lbracket, static_cast<int>(numbers::toInteger(idxObj)), std::move(valObj));
     return lstObj;
 }
 
@@ -409,36 +396,32 @@ OptSpicyObj SpicyEvaluator::execStmts(const std::vector<ast::StmtPtrVariant> &st
     return result;
 }
 
-void SpicyEvaluator::resolve(uint64_t exprAddr, uint32_t depth) {
-    m_locals.insert_or_assign(exprAddr, depth);
-}
-
 SpicyObj SpicyEvaluator::getLastObj() {
     return m_lastObj;
 }
 
 void SpicyEvaluator::initBuiltins() {
-    m_envMgr.defineGlobal("clock", std::make_shared<ClockBuiltIn>());
-    m_envMgr.defineGlobal("str", std::make_shared<StrBuiltIn>());
-    m_envMgr.defineGlobal("sqrt", std::make_shared<SqrtBuiltIn>());
-    m_envMgr.defineGlobal("len", std::make_shared<LenBuiltIn>());
-    m_envMgr.defineGlobal("front", std::make_shared<FrontBuiltIn>());
-    m_envMgr.defineGlobal("back", std::make_shared<BackBuiltIn>());
+    for (const auto& builtin : getBuiltins()) {
+        m_envMgr.defineGlobal(builtin->getFuncName(), builtin);
+    }
 }
 
 OptSpicyObj SpicyEvaluator::execExpressionStmt(const ast::ExprStmtPtr &stmt) {
-    // TODO: need to hook in a value to determine if we're in a repl loop or not (?)
-    evalExpr(stmt->expression);
+    auto value = evalExpr(stmt->expression);
+    if (m_isRepl) m_lastObj = std::move(value);
     return std::nullopt;
 }
 
 OptSpicyObj SpicyEvaluator::execPrintStmt(const ast::PrintStmtPtr &stmt) {
-    const auto& value = evalExpr(stmt->expression);
-    std::cout << getObjString(value) << '\n';
+    auto value = evalExpr(stmt->expression);
+    std::cout << value << '\n';
+    if (m_isRepl) m_lastObj = std::move(value);
     return std::nullopt;
 }
 
 OptSpicyObj SpicyEvaluator::execBlockStmt(const ast::BlockStmtPtr &stmt) {
+    if (!stmt->hasScope)
+        return execStmts(stmt->statements);
     OptSpicyObj result = std::nullopt;
     const auto& prevEnv = m_envMgr.getCurrentEnvironment();
     m_envMgr.createNewEnvironment("execBlockStmt");
@@ -448,11 +431,9 @@ OptSpicyObj SpicyEvaluator::execBlockStmt(const ast::BlockStmtPtr &stmt) {
 }
 
 OptSpicyObj SpicyEvaluator::execVarStmt(const ast::VarStmtPtr &stmt) {
-    if (stmt->initializer.has_value()) {
-        m_envMgr.define(stmt->varName, evalExpr(stmt->initializer.value()));
-    } else {
-        m_envMgr.define(stmt->varName, SpicyObj{nullptr});
-    }
+    auto value = stmt->initializer.has_value() ? evalExpr(stmt->initializer.value()) : SpicyObj{nullptr};
+    if (m_isRepl) m_lastObj = value;
+    m_envMgr.define(stmt->varName, std::move(value));
     return std::nullopt;
 }
 
@@ -469,14 +450,14 @@ OptSpicyObj SpicyEvaluator::execIfStmt(const ast::IfStmtPtr &stmt) {
 
 OptSpicyObj SpicyEvaluator::execWhileStmt(const ast::WhileStmtPtr &stmt) {
     OptSpicyObj result = std::nullopt;
-    while (isTrue(evalExpr(stmt->condition)) && !result.has_value()) {
+    while (!result.has_value() && isTrue(evalExpr(stmt->condition))) {
         result = execStmt(stmt->loopBody);
     }
     return result;
 }
 
 OptSpicyObj SpicyEvaluator::execFuncStmt(const ast::FuncStmtPtr &stmt) {
-    auto func = std::make_shared<FuncObj>(
+    auto func = makeRef<FuncObj>(
                     stmt->funcExpr,
                     stmt->funcName.lexeme,
                     m_envMgr.getCurrentEnvironment()
@@ -486,22 +467,32 @@ OptSpicyObj SpicyEvaluator::execFuncStmt(const ast::FuncStmtPtr &stmt) {
 }
 
 OptSpicyObj SpicyEvaluator::execRetStmt(const ast::RetStmtPtr &stmt) {
+    if (stmt->isTailCall) {
+        const auto& expr = std::get<ast::CallExprPtr>(stmt->value.value());
+        auto [callee, receiver] = evalCallee(expr->callee);
+        if (!callee.is<FuncSharedPtr>())
+            return call(callee, std::move(receiver), expr);
+        // the call is left for the trampoline in call(), which runs it in place of the function returning here.
+        // nil only stands in for the result so that the enclosing statements stop
+        const auto func = callee.as<FuncSharedPtr>();
+        m_tailCall = TailCall{ func, newFrame(func, std::move(receiver), expr) };
+        return SpicyObj{nullptr};
+    }
     return stmt->value.has_value()
               ? std::make_optional(evalExpr(stmt->value.value()))
               : std::nullopt;
 }
 
 OptSpicyObj SpicyEvaluator::execClassStmt(const ast::ClassStmtPtr &stmt) {
-    m_envMgr.define(stmt->className, std::format("<class {}>", stmt->className.lexeme));
     std::vector<std::pair<std::string, SpicyObj>> methods;
 
     const auto hasSuperClass = stmt->superClass.has_value();
     auto superClass = [&]() -> std::optional<SpicyClassSharedPtr> {
         if (hasSuperClass) {
             auto superClassObj = evalExpr(stmt->superClass.value());
-            if (!std::holds_alternative<SpicyClassSharedPtr>(superClassObj))
+            if (!superClassObj.is<SpicyClassSharedPtr>())
                 throw RuntimeError(stmt->className, "Superclass must be a class; cannot inherit from a non-class.");
-            return std::get<SpicyClassSharedPtr>(superClassObj);
+            return superClassObj.as<SpicyClassSharedPtr>();
         }
         return std::nullopt;
     }();
@@ -514,7 +505,7 @@ OptSpicyObj SpicyEvaluator::execClassStmt(const ast::ClassStmtPtr &stmt) {
     for (const auto& method : stmt->methods) {
         methods.emplace_back(
             method->funcName.lexeme,
-            std::make_shared<FuncObj>(
+            makeRef<FuncObj>(
                 method->funcExpr,
                 method->funcName.lexeme,
                 m_envMgr.getCurrentEnvironment(),
@@ -523,7 +514,7 @@ OptSpicyObj SpicyEvaluator::execClassStmt(const ast::ClassStmtPtr &stmt) {
         );
     }
 
-    auto class_ = std::make_shared<SpicyClass>(
+    auto class_ = makeRef<SpicyClass>(
                     stmt->className.lexeme,
                     std::move(superClass),
                     std::move(methods)
@@ -534,32 +525,32 @@ OptSpicyObj SpicyEvaluator::execClassStmt(const ast::ClassStmtPtr &stmt) {
                     m_envMgr.getCurrentEnvironment()->getParent(),
                     "execClassStmt");
 
-    m_envMgr.assign(stmt->className, std::move(class_));
+    m_envMgr.define(stmt->className, std::move(class_));
     return std::nullopt;
 }
 
-SpicyObj SpicyEvaluator::lookUpVariable(Token name, uint64_t exprAddr) {
-    if (const auto distance = m_locals.find(exprAddr);
-        distance != m_locals.end())
-        return m_envMgr.get(distance->second, name);
+SpicyObj SpicyEvaluator::lookUpVariable(Token name, ast::NodeId id) {
+    if (const auto local = m_locals.find(id); local.has_value())
+        return m_envMgr.get(local->distance, local->slot);
     else
         return m_envMgr.getGlobal(name);
 }
 
-FuncSharedPtr SpicyEvaluator::bindInstance(const FuncSharedPtr &method, SpicyInstanceSharedPtr instance) {
-    const auto envToRestore = m_envMgr.getCurrentEnvironment();
-    m_envMgr.setCurrentEnvironment(method->getClosure(), method->getFuncName());
-    m_envMgr.createNewEnvironment(method->getFuncName());
-    const auto methodClosure = m_envMgr.getCurrentEnvironment();
-    m_envMgr.define("this", instance);
-    m_envMgr.setCurrentEnvironment(envToRestore, method->getFuncName());
-    return std::make_shared<FuncObj>(
-                method->getDecl(),
-                method->getFuncName(),
-                methodClosure,
-                method->isMethod(),
-                method->isInit()
-                );
+Environment::EnvironmentPtr SpicyEvaluator::newFrame(const FuncSharedPtr& func, SpicyInstanceSharedPtr receiver,
+                                                     const ast::CallExprPtr& expr) {
+    if (expr->arguments.size() != func->arity())
+        throw RuntimeError(expr->paren, std::format("Expected {} argurments but got {}.", func->arity(), expr->arguments.size()));
+
+    // the arguments are evaluated in the caller's environment, straight into the parameter slots of the new one.
+    // methods get their receiver ahead of them, either the one called on or the one they were bound to
+    auto frame = m_envMgr.newEnvironment(func->getClosure(), func->getFuncName());
+    if (func->isMethod())
+        frame->define(receiver != nullptr ? std::move(receiver) : func->getReceiver());
+    for (const auto& arg : expr->arguments)
+        frame->define(evalExpr(arg));
+
+    SPICY_LOG(log::Category::Call, "[line {}] calling {} with {} args", expr->paren.line, func->getFuncName(), expr->arguments.size());
+    return frame;
 }
 
 SpicyObj SpicyEvaluator::evalBuiltInCall(const BuiltinFuncSharedPtr &builtin, const ast::CallExprPtr &expr) {
@@ -570,8 +561,7 @@ SpicyObj SpicyEvaluator::evalBuiltInCall(const BuiltinFuncSharedPtr &builtin, co
     for (const auto& arg : expr->arguments)
         args.emplace_back(evalExpr(arg));
 
-    builtin->setArgs(args);
-    return builtin->run();
+    return builtin->run(args);
 }
 
 } // namespace spicy::eval
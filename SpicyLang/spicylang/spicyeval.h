@@ -2,29 +2,55 @@
 #ifndef H_SPICYEVAL
 #define H_SPICYEVAL
 
+#include <optional>
+
 #include "spicyast.h"
 #include "spicyobjects.h"
 #include "spicyenvironment.h"
+#include "spicyresolver.h"
 
 namespace spicy::eval {
 
+// operand checks and helpers, shared with the closure-compiled evaluator
+namespace typecheck {
+void checkUnaryNumOperand(Token op, const SpicyObj& rhs);
+void checkBinaryNumOperands(Token op, const SpicyObj& lhs, const SpicyObj& rhs);
+void checkPlusOperands(Token op, const SpicyObj& lhs, const SpicyObj& rhs);
+void checkAppendOperands(Token op, const SpicyObj& lhs, const SpicyObj& rhs);
+} // namespace typecheck
+
+namespace internal {
+SpicyObj evalPlusBinOp(const SpicyObj& lval, const SpicyObj& rval);
+} // namespace internal
+
 struct SpicyExprEvaluator;
 struct SpicyStmtExecutor;
 
 class SpicyEvaluator {
+    // a call made from tail position, waiting for the trampoline to run it
+    struct TailCall {
+        FuncSharedPtr func;
+        Environment::EnvironmentPtr frame;
+    };
+    // what a call expression calls, and the instance it's called on when that's a method looked up in place
+    struct Callee {
+        SpicyObj value;
+        SpicyInstanceSharedPtr receiver;
+    };
+
     EnvironmentMgr m_envMgr{};
-    std::map<uint64_t, uint32_t> m_locals{};
+    const ResolvedLocals& m_locals;
     const bool m_isRepl;
-    SpicyObj m_lastObj{};
+    SpicyObj m_lastObj{};   // repl only: value of the last expression, print or var statement
+    std::optional<TailCall> m_tailCall;
 
 public:
-    explicit SpicyEvaluator(bool isRepl = false);
+    explicit SpicyEvaluator(const ResolvedLocals& locals, bool isRepl = false);
 
     SpicyObj evalExpr(const ast::ExprPtrVariant& expr);
     OptSpicyObj execStmt(const ast::StmtPtrVariant& stmt);
     OptSpicyObj execStmts(const std::vector<ast::StmtPtrVariant>& stmts);
 
-    void resolve(uint64_t exprAddr, uint32_t depth);
     SpicyObj getLastObj();
 
 private:
@@ -57,8 +83,10 @@ private:
     OptSpicyObj execRetStmt(const ast::RetStmtPtr& stmt);
     OptSpicyObj execClassStmt(const ast::ClassStmtPtr& stmt);
 
-    SpicyObj lookUpVariable(Token name, uint64_t exprAddr);
-    FuncSharedPtr bindInstance(const FuncSharedPtr& method, SpicyInstanceSharedPtr instance);
+    SpicyObj lookUpVariable(Token name, ast::NodeId id);
+    Callee evalCallee(const ast::ExprPtrVariant& callee);
+    SpicyObj call(const SpicyObj& callee, SpicyInstanceSharedPtr receiver, const ast::CallExprPtr& expr);
+    Environment::EnvironmentPtr newFrame(const FuncSharedPtr& func, SpicyInstanceSharedPtr receiver, const ast::CallExprPtr& expr);
     SpicyObj evalBuiltInCall(const BuiltinFuncSharedPtr& builtin, const ast::CallExprPtr& expr);
 
     friend struct SpicyExprEvaluator;
@@ -5,12 +5,16 @@
 #include <streambuf>
 #include <optional>
 #include <format>
+#include <span>
 
 #include "spicyscanner.h"
 #include "spicyparser.h"
 #include "spicyastprinter.h"
+#include "spicyclosures.h"
 #include "spicyobjects.h"
 #include "spicycompiler.h"
+#include "spicyprelude.h"
+#include "spicyserializer.h"
 #include "spicyvm.h"
 
 namespace spicy {
@@ -19,56 +23,72 @@ SpicyInterpreter::SpicyInterpreter(const std::string& scriptPath)
     : m_sScriptPath(scriptPath) {}
 
 void SpicyInterpreter::runTreeWalk() {
-    try {
-        std::cout << "runTreeWalk()\n";
-        loadScript();
-        SpicyScanner scanner(m_sRawScript);
-        SpicyParser parser(scanner.scanTokens());
-        m_program = std::move(parser.parseProgram());
+    std::cout << "runTreeWalk()\n";
+    parseScript();
+    if (!m_hadError)
         interpret();
-    }  catch (const SpicyParser::ParseError& err) {
-        std::cerr << "Script failed to parse." << '\n';
-    }
 }
 
-void SpicyInterpreter::runByteCode() {
-    try {
-        loadScript();
-        SpicyScanner scanner(m_sRawScript);
-        SpicyParser parser(scanner.scanTokens());
-        m_program = std::move(parser.parseProgram());
+void SpicyInterpreter::runClosures() {
+    parseScript();
+    if (!m_hadError)
+        interpretClosures();
+}
+
+void SpicyInterpreter::runByteCode(bool printStats) {
+    parseScript();
+    if (!m_hadError)
         interpretByteCode();
-    }  catch (const SpicyParser::ParseError& err) {
-        std::cerr << "Script failed to parse." << '\n';
-    }
+    if (printStats)
+        printCompileStats();
 }
 
 void SpicyInterpreter::repl() {
     auto line = std::string{};
     SpicyVM vm(true, true);
+    eval::SpicyResolver resolver(m_locals);
     getNextLine(line);
     while (line != "exit();") {
         SpicyScanner scanner(line);
-        SpicyCompiler compiler(scanner);
-        auto func = compiler.compile();
-        vm.execute(func.chunk);
+        SpicyParser parser(scanner.scanTokens(), m_nextNodeId);
+        auto&& parsed = parser.parseProgram();
+        m_nextNodeId = parser.nextNodeId();
+        const auto first = m_program.size();
+        m_program.insert(m_program.end(), std::make_move_iterator(parsed.begin()), std::make_move_iterator(parsed.end()));
+        try {
+            const auto added = std::span(m_program).subspan(first);
+            for (const auto& stmt : added)
+                resolver.resolve(stmt);
+            SpicyCompiler compiler(m_locals, m_compileStats);
+            auto func = compiler.compile(added);
+            if (!compiler.hadError())
+                vm.execute(func.chunk);
+        } catch (RuntimeError err) {
+            runtimeError(err);
+        }
         getNextLine(line);
     }
 }
 
 void SpicyInterpreter::replLegacy() {
     auto line = std::string{};
-    eval::SpicyEvaluator evaluator(true);
-    eval::SpicyResolver resolver(evaluator);
+    eval::SpicyEvaluator evaluator(m_locals, true);
+    eval::SpicyResolver resolver(m_locals);
     while (line != "exit();") {
         SpicyScanner scanner(line);
-        SpicyParser parser(scanner.scanTokens());
+        SpicyParser parser(scanner.scanTokens(), m_nextNodeId);
         auto&& parsed = parser.parseProgram();
+        m_nextNodeId = parser.nextNodeId();
+        const auto first = m_program.size();
         m_program.insert(m_program.end(), std::make_move_iterator(parsed.begin()), std::make_move_iterator(parsed.end()));
         try {
-            resolver.resolve(m_program.back());
-            evaluator.execStmt(m_program.back());
-            std::cout << std::format("{}\n", getObjString(evaluator.getLastObj()));
+            const auto added = std::span(m_program).subspan(first);
+            for (const auto& stmt : added) {
+                resolver.resolve(stmt);
+                evaluator.execStmt(stmt);
+            }
+            if (!added.empty())
+                std::cout << std::format("{}\n", getObjString(evaluator.getLastObj()));
         } catch (RuntimeError err) {
             runtimeError(err);
         }
@@ -98,16 +118,56 @@ bool SpicyInterpreter::hadRuntimeError() {
 
 void SpicyInterpreter::interpret() {
     try {
-        eval::SpicyEvaluator evaluator;
-        eval::SpicyResolver resolver(evaluator);
-        resolver.resolve(m_program);
+        eval::SpicyEvaluator evaluator(m_locals);
         evaluator.execStmts(m_program);
     } catch (RuntimeError err) {
         runtimeError(err);
     }
 }
 
+void SpicyInterpreter::interpretClosures() {
+    try {
+        eval::SpicyClosureEvaluator evaluator(m_locals);
+        const auto program = evaluator.compile(m_program);
+        program();
+    } catch (RuntimeError err) {
+        runtimeError(err);
+    }
+}
+
 void SpicyInterpreter::interpretByteCode() {
+    SpicyCompiler compiler(m_locals, m_compileStats);
+    const auto script = compiler.compile(m_program);
+    if (compiler.hadError()) {
+        m_hadError = true;
+        return;
+    }
+    SpicyVM vm(false, false);
+    vm.execute(script.chunk);
+}
+
+void SpicyInterpreter::emitPrelude() {
+    parseScript();
+    if (m_hadError) return;
+    SpicyCompiler compiler(m_locals, m_compileStats);
+    const auto script = compiler.compile(m_program);
+    if (compiler.hadError()) {
+        m_hadError = true;
+        return;
+    }
+    const auto bytecode = serializeChunk(script.chunk);
+    if (!bytecode.has_value()) {
+        std::cerr << "Unable to serialize the prelude.\n";
+        m_hadError = true;
+        return;
+    }
+    prelude::writeHeader(std::cout, bytecode.value());
+}
+
+void SpicyInterpreter::printCompileStats() const {
+    const auto& stats = *m_compileStats;
+    std::cout << std::format("[stats] functions: {} declared, {} compiled, {} never compiled\n",
+        stats.functions, stats.compiledBodies, stats.functions - stats.compiledBodies);
 }
 
 void SpicyInterpreter::loadScript() {
@@ -115,6 +175,25 @@ void SpicyInterpreter::loadScript() {
     m_sRawScript = std::string{std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
 }
 
+// scanning, parsing and resolving are shared by both engines, the resolved program can be handed to either
+void SpicyInterpreter::parseScript() {
+    try {
+        loadScript();
+        SpicyScanner scanner(m_sRawScript);
+        SpicyParser parser(scanner.scanTokens(), m_nextNodeId);
+        m_program = std::move(parser.parseProgram());
+        m_nextNodeId = parser.nextNodeId();
+        eval::SpicyResolver resolver(m_locals);
+        resolver.resolve(m_program);
+    } catch (const SpicyParser::ParseError& err) {
+        std::cerr << "Script failed to parse." << '\n';
+        m_hadError = true;
+    } catch (RuntimeError err) {
+        runtimeError(err);
+        m_hadError = true;
+    }
+}
+
 void SpicyInterpreter::getNextLine(std::string& line) {
     line.clear();
     std::cout << ">> ";
@@ -2,10 +2,12 @@
 #ifndef H_SPICYINTERPRETER
 #define H_SPICYINTERPRETER
 
+#include <memory>
 #include <string>
 
 #include "spicyscanner.h"
 #include "spicyast.h"
+#include "spicycompiler.h"
 #include "spicyeval.h"
 #include "spicyresolver.h"
 
@@ -18,26 +20,32 @@ class SpicyInterpreter {
     bool m_hadRuntimeError = false;
 
     ast::SpicyProgram m_program;
-    //eval::SpicyEvaluator m_evaluator;
-    //eval::SpicyResolver m_resolver;
+    ast::NodeId m_nextNodeId = 0;
+    eval::ResolvedLocals m_locals;
+    std::shared_ptr<CompileStats> m_compileStats = std::make_shared<CompileStats>();
 public:
     SpicyInterpreter(const std::string& scriptPath);
     
     void runTreeWalk();
-    void runByteCode();
+    void runClosures();
+    void runByteCode(bool printStats = false);
     void repl();
     void replLegacy();
 
     void dumpAST();
+    void emitPrelude();
     
     bool hadError();
     bool hadRuntimeError();
     
 private:
     void interpret();
+    void interpretClosures();
     void interpretByteCode();
     void loadScript();
+    void parseScript();
     
+    void printCompileStats() const;
     void getNextLine(std::string& line);
 };
     
@@ -0,0 +1,286 @@
+#include "spicykernels.h"
+
+#include <algorithm>
+#include <cstddef>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define SPICY_KERNELS_X64
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// gcc and clang only let a function use instructions past the baseline if it says so, msvc always does
+#if defined(SPICY_KERNELS_X64) && (defined(__GNUC__) || defined(__clang__))
+#define SPICY_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SPICY_TARGET_AVX2
+#endif
+
+namespace spicy::kernels {
+
+namespace {
+
+struct KernelTable {
+    double (*sum)(const double* xs, size_t n);
+    double (*dot)(const double* xs, const double* ys, size_t n);
+    double (*min)(const double* xs, size_t n);
+    double (*max)(const double* xs, size_t n);
+    void (*scale)(double a, const double* xs, double* out, size_t n);
+    void (*add)(const double* xs, const double* ys, double* out, size_t n);
+    void (*axpy)(double a, const double* xs, const double* ys, double* out, size_t n);
+};
+
+// ========================================= scalar =========================================
+// also used by the vector versions for the elements left over after the last full register
+namespace scalar {
+
+double sum(const double* xs, size_t n) {
+    auto total = 0.0;
+    for (auto i = size_t{0}; i < n; ++i) total += xs[i];
+    return total;
+}
+
+double dot(const double* xs, const double* ys, size_t n) {
+    auto total = 0.0;
+    for (auto i = size_t{0}; i < n; ++i) total += xs[i] * ys[i];
+    return total;
+}
+
+double min(const double* xs, size_t n) {
+    return *std::min_element(xs, xs + n);
+}
+
+double max(const double* xs, size_t n) {
+    return *std::max_element(xs, xs + n);
+}
+
+void scale(double a, const double* xs, double* out, size_t n) {
+    for (auto i = size_t{0}; i < n; ++i) out[i] = a * xs[i];
+}
+
+void add(const double* xs, const double* ys, double* out, size_t n) {
+    for (auto i = size_t{0}; i < n; ++i) out[i] = xs[i] + ys[i];
+}
+
+void axpy(double a, const double* xs, const double* ys, double* out, size_t n) {
+    for (auto i = size_t{0}; i < n; ++i) out[i] = a * xs[i] + ys[i];
+}
+
+constexpr auto table = KernelTable{ sum, dot, min, max, scale, add, axpy };
+
+} // namespace scalar
+
+#ifdef SPICY_KERNELS_X64
+// ========================================== SSE2 ==========================================
+// part of x86-64 itself, always there
+namespace sse2 {
+
+double horizontalSum(__m128d v) {
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+double sum(const double* xs, size_t n) {
+    auto acc0 = _mm_setzero_pd();
+    auto acc1 = _mm_setzero_pd();
+    auto i = size_t{0};
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm_add_pd(acc0, _mm_loadu_pd(xs + i));
+        acc1 = _mm_add_pd(acc1, _mm_loadu_pd(xs + i + 2));
+    }
+    return horizontalSum(_mm_add_pd(acc0, acc1)) + scalar::sum(xs + i, n - i);
+}
+
+double dot(const double* xs, const double* ys, size_t n) {
+    auto acc0 = _mm_setzero_pd();
+    auto acc1 = _mm_setzero_pd();
+    auto i = size_t{0};
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(xs + i), _mm_loadu_pd(ys + i)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(xs + i + 2), _mm_loadu_pd(ys + i + 2)));
+    }
+    return horizontalSum(_mm_add_pd(acc0, acc1)) + scalar::dot(xs + i, ys + i, n - i);
+}
+
+double min(const double* xs, size_t n) {
+    if (n < 2) return scalar::min(xs, n);
+    auto acc = _mm_loadu_pd(xs);
+    auto i = size_t{2};
+    for (; i + 2 <= n; i += 2) acc = _mm_min_pd(acc, _mm_loadu_pd(xs + i));
+    const auto result = _mm_cvtsd_f64(_mm_min_sd(acc, _mm_unpackhi_pd(acc, acc)));
+    return i < n ? std::min(result, scalar::min(xs + i, n - i)) : result;
+}
+
+double max(const double* xs, size_t n) {
+    if (n < 2) return scalar::max(xs, n);
+    auto acc = _mm_loadu_pd(xs);
+    auto i = size_t{2};
+    for (; i + 2 <= n; i += 2) acc = _mm_max_pd(acc, _mm_loadu_pd(xs + i));
+    const auto result = _mm_cvtsd_f64(_mm_max_sd(acc, _mm_unpackhi_pd(acc, acc)));
+    return i < n ? std::max(result, scalar::max(xs + i, n - i)) : result;
+}
+
+void scale(double a, const double* xs, double* out, size_t n) {
+    const auto factor = _mm_set1_pd(a);
+    auto i = size_t{0};
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(out + i, _mm_mul_pd(factor, _mm_loadu_pd(xs + i)));
+    scalar::scale(a, xs + i, out + i, n - i);
+}
+
+void add(const double* xs, const double* ys, double* out, size_t n) {
+    auto i = size_t{0};
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(xs + i), _mm_loadu_pd(ys + i)));
+    scalar::add(xs + i, ys + i, out + i, n - i);
+}
+
+void axpy(double a, const double* xs, const double* ys, double* out, size_t n) {
+    const auto factor = _mm_set1_pd(a);
+    auto i = size_t{0};
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(out + i, _mm_add_pd(_mm_mul_pd(factor, _mm_loadu_pd(xs + i)), _mm_loadu_pd(ys + i)));
+    }
+    scalar::axpy(a, xs + i, ys + i, out + i, n - i);
+}
+
+constexpr auto table = KernelTable{ sum, dot, min, max, scale, add, axpy };
+
+} // namespace sse2
+
+// ========================================== AVX2 ==========================================
+// a multiply and an add rather than a fused one, so that results don't depend on the machine
+namespace avx2 {
+
+SPICY_TARGET_AVX2 double horizontalSum(__m256d v) {
+    const auto half = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+}
+
+SPICY_TARGET_AVX2 double sum(const double* xs, size_t n) {
+    auto acc0 = _mm256_setzero_pd();
+    auto acc1 = _mm256_setzero_pd();
+    auto i = size_t{0};
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(xs + i));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(xs + i + 4));
+    }
+    return horizontalSum(_mm256_add_pd(acc0, acc1)) + sse2::sum(xs + i, n - i);
+}
+
+SPICY_TARGET_AVX2 double dot(const double* xs, const double* ys, size_t n) {
+    auto acc0 = _mm256_setzero_pd();
+    auto acc1 = _mm256_setzero_pd();
+    auto i = size_t{0};
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(xs + i), _mm256_loadu_pd(ys + i)));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(xs + i + 4), _mm256_loadu_pd(ys + i + 4)));
+    }
+    return horizontalSum(_mm256_add_pd(acc0, acc1)) + sse2::dot(xs + i, ys + i, n - i);
+}
+
+SPICY_TARGET_AVX2 double min(const double* xs, size_t n) {
+    if (n < 4) return sse2::min(xs, n);
+    auto acc = _mm256_loadu_pd(xs);
+    auto i = size_t{4};
+    for (; i + 4 <= n; i += 4) acc = _mm256_min_pd(acc, _mm256_loadu_pd(xs + i));
+    const auto half = _mm_min_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+    const auto result = _mm_cvtsd_f64(_mm_min_sd(half, _mm_unpackhi_pd(half, half)));
+    return i < n ? std::min(result, sse2::min(xs + i, n - i)) : result;
+}
+
+SPICY_TARGET_AVX2 double max(const double* xs, size_t n) {
+    if (n < 4) return sse2::max(xs, n);
+    auto acc = _mm256_loadu_pd(xs);
+    auto i = size_t{4};
+    for (; i + 4 <= n; i += 4) acc = _mm256_max_pd(acc, _mm256_loadu_pd(xs + i));
+    const auto half = _mm_max_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+    const auto result = _mm_cvtsd_f64(_mm_max_sd(half, _mm_unpackhi_pd(half, half)));
+    return i < n ? std::max(result, sse2::max(xs + i, n - i)) : result;
+}
+
+SPICY_TARGET_AVX2 void scale(double a, const double* xs, double* out, size_t n) {
+    const auto factor = _mm256_set1_pd(a);
+    auto i = size_t{0};
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(out + i, _mm256_mul_pd(factor, _mm256_loadu_pd(xs + i)));
+    sse2::scale(a, xs + i, out + i, n - i);
+}
+
+SPICY_TARGET_AVX2 void add(const double* xs, const double* ys, double* out, size_t n) {
+    auto i = size_t{0};
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(xs + i), _mm256_loadu_pd(ys + i)));
+    }
+    sse2::add(xs + i, ys + i, out + i, n - i);
+}
+
+SPICY_TARGET_AVX2 void axpy(double a, const double* xs, const double* ys, double* out, size_t n) {
+    const auto factor = _mm256_set1_pd(a);
+    auto i = size_t{0};
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_mul_pd(factor, _mm256_loadu_pd(xs + i)), _mm256_loadu_pd(ys + i)));
+    }
+    sse2::axpy(a, xs + i, ys + i, out + i, n - i);
+}
+
+constexpr auto table = KernelTable{ sum, dot, min, max, scale, add, axpy };
+
+} // namespace avx2
+
+bool hasAvx2() {
+#ifdef _MSC_VER
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7) return false;
+    // the os has to save the ymm registers too, not just the cpu have them
+    __cpuid(regs, 1);
+    const auto osxsave = (regs[2] & (1 << 27)) != 0;
+    const auto avx = (regs[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif // SPICY_KERNELS_X64
+
+const KernelTable& kernels() {
+#ifdef SPICY_KERNELS_X64
+    static const auto& table = hasAvx2() ? avx2::table : sse2::table;
+#else
+    static const auto& table = scalar::table;
+#endif
+    return table;
+}
+
+} // namespace
+
+double sum(std::span<const double> xs) {
+    return kernels().sum(xs.data(), xs.size());
+}
+
+double dot(std::span<const double> xs, std::span<const double> ys) {
+    return kernels().dot(xs.data(), ys.data(), xs.size());
+}
+
+double min(std::span<const double> xs) {
+    return kernels().min(xs.data(), xs.size());
+}
+
+double max(std::span<const double> xs) {
+    return kernels().max(xs.data(), xs.size());
+}
+
+void scale(double a, std::span<const double> xs, std::span<double> out) {
+    kernels().scale(a, xs.data(), out.data(), xs.size());
+}
+
+void add(std::span<const double> xs, std::span<const double> ys, std::span<double> out) {
+    kernels().add(xs.data(), ys.data(), out.data(), xs.size());
+}
+
+void axpy(double a, std::span<const double> xs, std::span<const double> ys, std::span<double> out) {
+    kernels().axpy(a, xs.data(), ys.data(), out.data(), xs.size());
+}
+
+} // namespace spicy::kernels
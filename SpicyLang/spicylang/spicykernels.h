@@ -0,0 +1,30 @@
+#pragma once
+#ifndef H_SPICYKERNELS
+#define H_SPICYKERNELS
+
+#include <span>
+
+namespace spicy::kernels {
+
+/*
+ * Loops over arrays of doubles, the numeric list builtins run on these. Each one has an AVX2, an SSE2 and a plain
+ * implementation, the best one the cpu supports is picked the first time any of them is called.
+ * The reductions add up several lanes side by side, so their rounding can differ from a left to right loop.
+ */
+
+[[nodiscard]] double sum(std::span<const double> xs);
+[[nodiscard]] double dot(std::span<const double> xs, std::span<const double> ys);
+// xs can't be empty
+[[nodiscard]] double min(std::span<const double> xs);
+[[nodiscard]] double max(std::span<const double> xs);
+
+// out[i] = a * xs[i]
+void scale(double a, std::span<const double> xs, std::span<double> out);
+// out[i] = xs[i] + ys[i]
+void add(std::span<const double> xs, std::span<const double> ys, std::span<double> out);
+// out[i] = a * xs[i] + ys[i]
+void axpy(double a, std::span<const double> xs, std::span<const double> ys, std::span<double> out);
+
+} // namespace spicy::kernels
+
+#endif // H_SPICYKERNELS
@@ -0,0 +1,32 @@
+#include "spicylog.h"
+
+#include <iostream>
+
+namespace spicy::log {
+
+namespace {
+uint8_t enabledCategories = 0;
+
+std::string_view categoryName(Category category) {
+    switch (category) {
+    case Category::Environment: return "env";
+    case Category::Call:        return "call";
+    case Category::Gc:          return "gc";
+    }
+    return "?";
+}
+} // namespace
+
+void enable(Category category) {
+    enabledCategories |= static_cast<uint8_t>(category);
+}
+
+bool isEnabled(Category category) {
+    return (enabledCategories & static_cast<uint8_t>(category)) != 0;
+}
+
+void write(Category category, std::string_view msg) {
+    std::clog << std::format("[{}] {}\n", categoryName(category), msg);
+}
+
+} // namespace spicy::log
@@ -0,0 +1,43 @@
+#pragma once
+#ifndef H_SPICYLOG
+#define H_SPICYLOG
+
+#include <cstdint>
+#include <format>
+#include <string_view>
+
+// logging is compiled in for debug builds only, define SPICY_LOGGING to get it anywhere else
+#if !defined(SPICY_LOGGING) && defined(_DEBUG)
+#define SPICY_LOGGING
+#endif
+
+namespace spicy::log {
+
+enum class Category : uint8_t {
+    Environment = 1 << 0,   // environments created, switched and discarded
+    Call        = 1 << 1,   // calls into user functions
+    Gc          = 1 << 2,   // environments going back to their pool
+};
+
+// categories are all off until enabled, from the command line
+void enable(Category category);
+[[nodiscard]] bool isEnabled(Category category);
+void write(Category category, std::string_view msg);
+
+} // namespace spicy::log
+
+/*
+ * SPICY_LOG(category, fmt, args...) formats and writes its message only if the category is enabled,
+ * the arguments aren't even evaluated otherwise. Without SPICY_LOGGING it expands to nothing at all.
+ */
+#ifdef SPICY_LOGGING
+#define SPICY_LOG(category, ...)                                                        \
+    do {                                                                                \
+        if (::spicy::log::isEnabled(category))                                          \
+            ::spicy::log::write(category, std::format(__VA_ARGS__));                    \
+    } while (false)
+#else
+#define SPICY_LOG(category, ...) do {} while (false)
+#endif
+
+#endif // H_SPICYLOG
@@ -1,81 +1,160 @@
 #include "spicyobjects.h"
 
+#include <algorithm>
 #include <format>
+#include <limits>
 
 namespace spicy {
 
 bool areEqual(const SpicyObj &lhs, const SpicyObj &rhs) {
-    // if the indices aren't equal then they're obviously not equal
-    if (lhs.index() == rhs.index()) {
-        switch (lhs.index()) {
-        case 0:
-            return std::get<std::string>(lhs) == std::get<std::string>(rhs);
-        case 1:
-            return std::get<double>(lhs) == std::get<double>(rhs);
-        case 2:
-            return std::get<bool>(lhs) == std::get<bool>(rhs);
-        case 3:
-            return true;
-        case 4:
-            return std::get<FuncSharedPtr>(lhs)->getFuncName()
-                    == std::get<FuncSharedPtr>(rhs)->getFuncName();
-        case 5:
-            return std::get<BuiltinFuncSharedPtr>(lhs)->getFuncName()
-                    == std::get<BuiltinFuncSharedPtr>(rhs)->getFuncName();
-        case 6:
-            return std::get<SpicyClassSharedPtr>(lhs)->getClassName()
-                    == std::get<SpicyClassSharedPtr>(rhs)->getClassName();
-        case 7:
-            return std::get<SpicyInstanceSharedPtr>(lhs).get()
-                    == std::get<SpicyInstanceSharedPtr>(rhs).get();
-        case 8:
-            return *(std::get<SpicyListSharedPtr>(lhs).get())
-                    == *(std::get<SpicyListSharedPtr>(rhs).get());
-        default:
-        static_assert (std::variant_size_v<SpicyObj> == 9,
-            "SpicyObj cases missing in areEqual()!");
-        }
+    // an integer can equal a double
+    if (numbers::isNumber(lhs) && numbers::isNumber(rhs))
+        return numbers::compare<std::equal_to<>>(lhs, rhs);
+    // if the types aren't equal then they're obviously not equal
+    if (lhs.type() != rhs.type())
+        return false;
+    switch (lhs.type()) {
+    case SpicyType::String:
+        return lhs == rhs;
+    case SpicyType::Number:
+    case SpicyType::Int:
+        return false;   // handled above
+    case SpicyType::Bool:
+        return lhs.as<bool>() == rhs.as<bool>();
+    case SpicyType::Nil:
+        return true;
+    case SpicyType::Func:
+        return lhs.as<FuncSharedPtr>()->getFuncName()
+                == rhs.as<FuncSharedPtr>()->getFuncName();
+    case SpicyType::Builtin:
+        return lhs.as<BuiltinFuncSharedPtr>()->getFuncName()
+                == rhs.as<BuiltinFuncSharedPtr>()->getFuncName();
+    case SpicyType::Class:
+        return lhs.as<SpicyClassSharedPtr>()->getClassName()
+                == rhs.as<SpicyClassSharedPtr>()->getClassName();
+    case SpicyType::Instance:
+        return lhs.as<SpicyInstanceSharedPtr>() == rhs.as<SpicyInstanceSharedPtr>();
+    case SpicyType::List:
+        return *lhs.as<SpicyListSharedPtr>() == *rhs.as<SpicyListSharedPtr>();
     }
     return false;
 }
 
-struct ObjectStringVisitor {
-    std::string operator()(const std::string& str) { return str; }
-    std::string operator()(const double& dbl) { return std::to_string(dbl); }
-    std::string operator()(const bool& bol) { return bol ? "true" : "false"; }
-    std::string operator()(const std::nullptr_t& nilptr) { return "nil"; }
-    std::string operator()(const FuncSharedPtr& ptr) { return ptr->isMethod() ? "<method " + ptr->getFuncName() + ">" : "<fn " + ptr->getFuncName() + ">"; }
-    std::string operator()(const BuiltinFuncSharedPtr& ptr) { return "<builtin " + ptr->getFuncName() + ">"; }
-    std::string operator()(const SpicyClassSharedPtr& ptr) { return ptr->getClassName(); }
-    std::string operator()(const SpicyInstanceSharedPtr& ptr) { return ptr->toString(); }
-    std::string operator()(const SpicyListSharedPtr& ptr) { return ptr->toString(); }
-};
-
 std::string getObjString(const SpicyObj &obj) {
-    return std::visit(ObjectStringVisitor{}, obj);
+    switch (obj.type()) {
+    case SpicyType::String: return obj.as<std::string>();
+    case SpicyType::Number: return std::to_string(obj.as<double>());
+    case SpicyType::Int: return std::to_string(obj.as<int64_t>());
+    case SpicyType::Bool: return obj.as<bool>() ? "true" : "false";
+    case SpicyType::Nil: return "nil";
+    case SpicyType::Func: {
+        const auto func = obj.as<FuncSharedPtr>();
+        return func->isMethod() ? "<method " + func->getFuncName() + ">" : "<fn " + func->getFuncName() + ">";
+    }
+    case SpicyType::Builtin: return "<builtin " + obj.as<BuiltinFuncSharedPtr>()->getFuncName() + ">";
+    case SpicyType::Class: return obj.as<SpicyClassSharedPtr>()->getClassName();
+    case SpicyType::Instance: return obj.as<SpicyInstanceSharedPtr>()->toString();
+    case SpicyType::List: return obj.as<SpicyListSharedPtr>()->toString();
+    }
+    return "";
+}
+
+std::ostream& operator<<(std::ostream& out, const SpicyObj& obj) {
+    if (obj.is<std::string>())
+        return out << obj.as<std::string>();
+    return out << getObjString(obj);
 }
 
 bool isTrue(const SpicyObj &obj) {
-    if (std::holds_alternative<std::nullptr_t>(obj)) return false;
-    if (std::holds_alternative<bool>(obj)) return std::get<bool>(obj);
-    if (std::holds_alternative<FuncSharedPtr>(obj))
-        return std::get<FuncSharedPtr>(obj) == nullptr;
-    if (std::holds_alternative<BuiltinFuncSharedPtr>(obj))
-        return std::get<BuiltinFuncSharedPtr>(obj) == nullptr;
-    if (std::holds_alternative<SpicyClassSharedPtr>(obj))
-        return std::get<SpicyClassSharedPtr>(obj) == nullptr;
-    if (std::holds_alternative<SpicyInstanceSharedPtr>(obj))
-        return std::get<SpicyInstanceSharedPtr>(obj) == nullptr;
-    return true;
+    switch (obj.type()) {
+    case SpicyType::Nil: return false;
+    case SpicyType::Bool: return obj.as<bool>();
+    // a value always points at a live object, these used to be compared against nullptr
+    case SpicyType::Func:
+    case SpicyType::Builtin:
+    case SpicyType::Class:
+    case SpicyType::Instance: return false;
+    default: return true;
+    }
 }
 
+// ======================== numbers ================================
+namespace numbers {
+
+std::optional<int64_t> checkedAdd(int64_t lhs, int64_t rhs) {
+    if (rhs > 0 ? lhs > std::numeric_limits<int64_t>::max() - rhs : lhs < std::numeric_limits<int64_t>::min() - rhs)
+        return std::nullopt;
+    return lhs + rhs;
+}
+
+std::optional<int64_t> checkedMultiply(int64_t lhs, int64_t rhs) {
+    if (lhs == 0 || rhs == 0)
+        return int64_t{0};
+    constexpr auto min = std::numeric_limits<int64_t>::min();
+    if ((lhs == -1 && rhs == min) || (rhs == -1 && lhs == min))
+        return std::nullopt;
+    // the product wraps around in unsigned arithmetic, dividing it back tells whether it did
+    const auto product = static_cast<int64_t>(static_cast<uint64_t>(lhs) * static_cast<uint64_t>(rhs));
+    if (product / rhs != lhs)
+        return std::nullopt;
+    return product;
+}
+
+SpicyObj add(const SpicyObj &lhs, const SpicyObj &rhs) {
+    if (lhs.is<int64_t>() && rhs.is<int64_t>()) {
+        if (const auto sum = checkedAdd(lhs.as<int64_t>(), rhs.as<int64_t>()))
+            return *sum;
+    }
+    return toDouble(lhs) + toDouble(rhs);
+}
+
+SpicyObj subtract(const SpicyObj &lhs, const SpicyObj &rhs) {
+    if (lhs.is<int64_t>() && rhs.is<int64_t>()) {
+        const auto a = lhs.as<int64_t>();
+        const auto b = rhs.as<int64_t>();
+        if (b > 0 ? a >= std::numeric_limits<int64_t>::min() + b : a <= std::numeric_limits<int64_t>::max() + b)
+            return a - b;
+    }
+    return toDouble(lhs) - toDouble(rhs);
+}
+
+SpicyObj multiply(const SpicyObj &lhs, const SpicyObj &rhs) {
+    if (lhs.is<int64_t>() && rhs.is<int64_t>()) {
+        if (const auto product = checkedMultiply(lhs.as<int64_t>(), rhs.as<int64_t>()))
+            return *product;
+    }
+    return toDouble(lhs) * toDouble(rhs);
+}
+
+SpicyObj divide(const SpicyObj &lhs, const SpicyObj &rhs) {
+    if (lhs.is<int64_t>() && rhs.is<int64_t>()) {
+        const auto a = lhs.as<int64_t>();
+        const auto b = rhs.as<int64_t>();
+        if (b != 0 && !(a == std::numeric_limits<int64_t>::min() && b == -1) && a % b == 0)
+            return a / b;
+    }
+    return toDouble(lhs) / toDouble(rhs);
+}
+
+SpicyObj negate(const SpicyObj &obj) {
+    if (obj.is<int64_t>() && obj.as<int64_t>() != std::numeric_limits<int64_t>::min())
+        return -obj.as<int64_t>();
+    return -toDouble(obj);
+}
+
+} // namespace numbers
+
 // ======================== FuncObj ================================
 FuncObj::FuncObj(const ast::FuncExprPtr &decl, const std::string &funcName, std::shared_ptr<eval::Environment> closure, bool isMethod, bool isInit)
-    : m_decl(decl), m_funcName(funcName), m_closure(closure), m_isMethod(isMethod), m_isInit(isInit), m_chunk(nullptr) {
+    : SpicyHeapObj(SpicyType::Func), m_decl(&decl), m_funcName(funcName), m_arity(decl->parameters.size()), m_closure(closure), m_isMethod(isMethod), m_isInit(isInit), m_body(nullptr) {
+}
+
+FuncObj::FuncObj(const std::string &funcName, size_t arity, std::shared_ptr<FuncBody> body)
+    : SpicyHeapObj(SpicyType::Func), m_decl(nullptr), m_funcName(funcName), m_arity(arity), m_closure(nullptr), m_isMethod(false), m_isInit(false), m_body(std::move(body)) {
 }
 
 size_t FuncObj::arity() const {
-    return m_decl->parameters.size();
+    return m_arity;
 }
 
 std::shared_ptr<eval::Environment> FuncObj::getClosure() const {
@@ -83,11 +162,11 @@ std::shared_ptr<eval::Environment> FuncObj::getClosure() const {
 }
 
 const ast::FuncExprPtr &FuncObj::getDecl() const {
-    return m_decl;
+    return *m_decl;
 }
 
 std::vector<ast::StmtPtrVariant> &FuncObj::getBodyStmts() const {
-    return m_decl->body;
+    return (*m_decl)->body;
 }
 
 const std::string &FuncObj::getFuncName() const {
@@ -103,25 +182,65 @@ bool FuncObj::isInit() const {
 }
 
 const std::vector<Token> &FuncObj::getParams() const {
-    return m_decl->parameters;
+    return (*m_decl)->parameters;
 }
 
-// ======================== BuiltinFunc ================================
-BuiltinFunc::BuiltinFunc(const std::string &funcName, std::shared_ptr<eval::Environment> closure)
-    : m_funcName(funcName), m_closure(closure) {}
+const std::shared_ptr<FuncBody> &FuncObj::getBody() const {
+    return m_body;
+}
+
+std::vector<std::shared_ptr<Upvalue>> &FuncObj::getUpvalues() {
+    return m_upvalues;
+}
+
+const std::shared_ptr<const eval::CompiledBody> &FuncObj::getCompiledBody() const {
+    return m_compiled;
+}
+
+const SpicyInstanceSharedPtr &FuncObj::getReceiver() const {
+    return m_receiver;
+}
+
+FuncSharedPtr FuncObj::bind(SpicyInstanceSharedPtr receiver) const {
+    auto bound = makeRef<FuncObj>(*m_decl, m_funcName, m_closure, m_isMethod, m_isInit);
+    bound->m_compiled = m_compiled;
+    bound->m_receiver = std::move(receiver);
+    return bound;
+}
+
+void FuncObj::setBody(std::shared_ptr<FuncBody> body) {
+    m_body = std::move(body);
+}
 
-void BuiltinFunc::setArgs(const std::vector<SpicyObj> &args) {
-    m_args = args;
+void FuncObj::setCompiledBody(std::shared_ptr<const eval::CompiledBody> body) {
+    m_compiled = std::move(body);
 }
 
+// ======================== BuiltinFunc ================================
+BuiltinFunc::BuiltinFunc(const std::string &funcName)
+    : SpicyHeapObj(SpicyType::Builtin), m_funcName(funcName) {}
+
 // ======================== SpicyClass ================================
+static uint64_t nextClassId = 0;
+
+
 SpicyClass::SpicyClass(const std::string &name, std::optional<SpicyClassSharedPtr> superClass, const std::vector<std::pair<std::string, SpicyObj> > &methods)
-    : m_className(name), m_superClass(superClass) {
+    : SpicyHeapObj(SpicyType::Class), m_id(++nextClassId), m_className(name), m_superClass(superClass) {
+    // flattened once here, the superclass's table first and this class's own methods over it
+    if (m_superClass.has_value())
+        m_methods = m_superClass.value()->m_methods;
     for (const auto& [methodName, methodObj] : methods) {
-        m_methods.insert_or_assign(m_hasher(methodName), methodObj);
+        const auto index = methodIndex(methodName);
+        if (index >= m_methods.size())
+            m_methods.resize(index + 1, SpicyObj{nullptr});
+        m_methods[index] = methodObj;
     }
 }
 
+uint64_t SpicyClass::getId() const {
+    return m_id;
+}
+
 std::string SpicyClass::getClassName() const {
     return m_className;
 }
@@ -131,30 +250,65 @@ std::optional<SpicyClassSharedPtr> SpicyClass::getSuperClass() const {
 }
 
 std::optional<SpicyObj> SpicyClass::findMethod(const std::string &methodName) const {
-    if (auto iter = m_methods.find(m_hasher(methodName));
-        iter != m_methods.end()) {
-        return iter->second;
-    }
+    if (const auto* method = lookupMethod(methodIndex(methodName)))
+        return *method;
+    return std::nullopt;
+}
 
-    if (m_superClass.has_value()) {
-        return m_superClass.value()->findMethod(methodName);
-    }
+// the method stays where it is for as long as its class lives, that's what lets inline caches point at it
+const SpicyObj* SpicyClass::lookupMethod(MethodIndex index) const {
+    if (index >= m_methods.size() || m_methods[index].is<std::nullptr_t>())
+        return nullptr;
+    return &m_methods[index];
+}
 
+size_t SpicyClass::getFieldCount() const {
+    return m_fieldCount;
+}
+
+void SpicyClass::noteFieldCount(size_t count) const {
+    m_fieldCount = std::max(m_fieldCount, count);
+}
+
+// ======================== Shape ================================
+Shape::Shape(std::vector<size_t> keys) : m_keys(std::move(keys)) {}
+
+const Shape* Shape::empty() {
+    static const Shape root{ {} };
+    return &root;
+}
+
+// instances have a handful of fields, a scan beats hashing. The caches on the nodes make this rare anyway
+std::optional<uint32_t> Shape::slotOf(size_t key) const {
+    for (auto slot = 0u; slot < m_keys.size(); ++slot) {
+        if (m_keys[slot] == key)
+            return slot;
+    }
     return std::nullopt;
 }
 
+const Shape* Shape::withField(size_t key) const {
+    auto& next = m_transitions[key];
+    if (next == nullptr) {
+        auto keys = m_keys;
+        keys.push_back(key);
+        next.reset(new Shape(std::move(keys)));
+    }
+    return next.get();
+}
+
 // ======================== SpicyInstance ================================
-SpicyInstance::SpicyInstance(SpicyClassSharedPtr class_) : m_class(class_) {}
+SpicyInstance::SpicyInstance(SpicyClassSharedPtr class_) : SpicyHeapObj(SpicyType::Instance), m_class(std::move(class_)) {
+    m_slots.reserve(m_class->getFieldCount());
+}
 
 std::string SpicyInstance::toString() const {
     return "Instance of " + m_class->getClassName();
 }
 
 SpicyObj SpicyInstance::get(const Token &fieldName) const {
-    if (auto iter = m_fields.find(m_hasher(fieldName.lexeme));
-        iter != m_fields.end()) {
-        return iter->second;
-    }
+    if (const auto slot = m_shape->slotOf(std::hash<std::string>{}(fieldName.lexeme)))
+        return m_slots[*slot];
     const auto& method = m_class->findMethod(fieldName.lexeme);
     if (method.has_value()) return method.value();
 
@@ -162,78 +316,208 @@ SpicyObj SpicyInstance::get(const Token &fieldName) const {
 }
 
 SpicyObj SpicyInstance::get(const std::string &fieldName) const {
-    if (auto iter = m_fields.find(m_hasher(fieldName));
-        iter != m_fields.end()) {
-        return iter->second;
-    }
+    if (const auto slot = m_shape->slotOf(std::hash<std::string>{}(fieldName)))
+        return m_slots[*slot];
     const auto& method = m_class->findMethod(fieldName);
     if (method.has_value()) return method.value();
     throw std::exception{}; // TODO
 }
 
+SpicyObj SpicyInstance::get(const Token &fieldName, ast::PropertyCache &cache) const {
+    if (const auto* field = findField(cache.field))
+        return *field;
+    return getMethod(fieldName, cache);
+}
+
+const SpicyObj* SpicyInstance::findField(ast::FieldCache &cache) const {
+    if (cache.shape != m_shape)
+        updateCache(cache);
+    return cache.slot.has_value() ? &m_slots[*cache.slot] : nullptr;
+}
+
+const SpicyObj& SpicyInstance::getMethod(const Token &name, ast::PropertyCache &cache) const {
+    // same id means same class, and a live one since this instance holds it
+    if (cache.classId != m_class->getId()) {
+        cache.classId = m_class->getId();
+        cache.method = m_class->lookupMethod(cache.index);
+    }
+    if (cache.method == nullptr)
+        throw RuntimeError(name, "Undefined property '" + name.lexeme + "'.");
+    return *cache.method;
+}
+
+const SpicyClassSharedPtr& SpicyInstance::getClass() const {
+    return m_class;
+}
+
 void SpicyInstance::set(const Token &fieldName, SpicyObj value) {
-    m_fields.insert_or_assign(m_hasher(fieldName.lexeme), std::move(value));
+    set(std::hash<std::string>{}(fieldName.lexeme), std::move(value));
+}
+
+void SpicyInstance::set(ast::FieldCache &cache, SpicyObj value) {
+    if (cache.shape != m_shape)
+        updateCache(cache);
+    if (cache.slot.has_value()) {
+        m_slots[*cache.slot] = std::move(value);
+        return;
+    }
+    // new fields always go in the next slot, the transition is all there is to remember
+    if (cache.grown == nullptr)
+        cache.grown = m_shape->withField(cache.key);
+    m_shape = cache.grown;
+    m_slots.emplace_back(std::move(value));
+    m_class->noteFieldCount(m_slots.size());
+}
+
+void SpicyInstance::set(size_t key, SpicyObj value) {
+    if (const auto slot = m_shape->slotOf(key)) {
+        m_slots[*slot] = std::move(value);
+        return;
+    }
+    m_shape = m_shape->withField(key);
+    m_slots.emplace_back(std::move(value));
+    m_class->noteFieldCount(m_slots.size());
+}
+
+void SpicyInstance::updateCache(ast::FieldCache &cache) const {
+    cache.shape = m_shape;
+    cache.slot = m_shape->slotOf(cache.key);
+    cache.grown = nullptr;
 }
 
 // ======================= SpicyList ===========================
+namespace {
+// integers and doubles are both numbers, they can share a list
+bool sameElementType(const SpicyObj& lhs, const SpicyObj& rhs) {
+    return lhs.type() == rhs.type() || (numbers::isNumber(lhs) && numbers::isNumber(rhs));
+}
+
+// the storage a list whose first element is val starts out with
+SpicyList::Storage storageFor(const SpicyObj& val) {
+    switch (val.type()) {
+    case SpicyType::Int: return util::GapVector<int64_t>{};
+    case SpicyType::Number: return util::GapVector<double>{};
+    case SpicyType::Bool: return util::GapVector<bool>{};
+    default: return util::GapVector<SpicyObj>{};
+    }
+}
+
+template <typename T>
+bool fits(const util::GapVector<T>&, const SpicyObj& val) {
+    if constexpr (std::is_same_v<T, SpicyObj>) return true;
+    else return val.is<T>();
+}
+
+template <typename T>
+SpicyObj boxed(const util::GapVector<T>& items, size_t idx) {
+    if constexpr (std::is_same_v<T, SpicyObj>) return items[idx];
+    else return SpicyObj(static_cast<T>(items[idx]));
+}
+
+template <typename T>
+T unboxed(SpicyObj val) {
+    if constexpr (std::is_same_v<T, SpicyObj>) return val;
+    else return val.as<T>();
+}
+}
+
+void SpicyList::insert(SpicyObj val, bool atFront) {
+    if (length() == 0)
+        m_items = storageFor(val);
+    else if (!std::visit([&](const auto& items) { return fits(items, val); }, m_items))
+        generalize();
+    std::visit([&](auto& items) {
+        using T = typename std::decay_t<decltype(items)>::value_type;
+        if (atFront) items.pushFront(unboxed<T>(std::move(val)));
+        else items.pushBack(unboxed<T>(std::move(val)));
+    }, m_items);
+}
+
+void SpicyList::generalize() {
+    auto values = util::GapVector<SpicyObj>{};
+    values.reserve(length());
+    std::visit([&](const auto& items) {
+        for (auto i = size_t{0}; i < items.size(); ++i)
+            values.pushBack(boxed(items, i));
+    }, m_items);
+    m_items = std::move(values);
+}
+
+SpicyObj SpicyList::at(size_t idx) const {
+    return std::visit([idx](const auto& items) { return boxed(items, idx); }, m_items);
+}
+
+size_t SpicyList::length() const {
+    return std::visit([](const auto& items) { return items.size(); }, m_items);
+}
+
 void SpicyList::append(const Token& lstName, SpicyObj val) {
-    if (!m_list.empty() && m_list.front().index() != val.index()) {
+    if (length() != 0 && !sameElementType(at(0), val)) {
         throw RuntimeError(lstName, "All elements of a list must be of the same type.");
     }
-    m_list.emplace_back(val);
+    insert(std::move(val), false);
 }
 
 void SpicyList::appendFront(const Token& lstName, SpicyObj val) {
-    if (!m_list.empty() && m_list.front().index() != val.index()) {
+    if (length() != 0 && !sameElementType(at(0), val)) {
         throw RuntimeError(lstName, "All elements of a list must be of the same type.");
     }
-    m_list.emplace_front(val);
+    insert(std::move(val), true);
 }
 
 SpicyObj SpicyList::get(const Token& lstName, int idx) {
-    if (idx < 0 || idx >= m_list.size()) {
-        throw RuntimeError(lstName, std::format("Index '{}' out of bounds. Array size is {}", idx, m_list.size()));
+    if (idx < 0 || idx >= length()) {
+        throw RuntimeError(lstName, std::format("Index '{}' out of bounds. Array size is {}", idx, length()));
     }
-    return m_list[idx];
+    return at(idx);
 }
 
 SpicyObj SpicyList::set(const Token& lstName, int idx, SpicyObj val) {
-    if (idx < 0 || idx >= m_list.size()) {
-        throw RuntimeError(lstName, std::format("Index '{}' out of bounds. Array size is {}", idx, m_list.size()));
+    if (idx < 0 || idx >= length()) {
+        throw RuntimeError(lstName, std::format("Index '{}' out of bounds. Array size is {}", idx, length()));
     }
-    m_list[idx] = val;
+    if (!std::visit([&](const auto& items) { return fits(items, val); }, m_items))
+        generalize();
+    std::visit([&](auto& items) {
+        using T = typename std::decay_t<decltype(items)>::value_type;
+        items[idx] = unboxed<T>(std::move(val));
+    }, m_items);
     return nullptr;
 }
 
 SpicyObj SpicyList::back() {
-    if (m_list.empty()) {
+    if (length() == 0) {
         return nullptr;
     }
-    return m_list.back();
+    return at(length() - 1);
 }
 
 SpicyObj SpicyList::front() {
-    if (m_list.empty()) {
+    if (length() == 0) {
         return nullptr;
     }
-    return m_list.front();
+    return at(0);
 }
 
 SpicyObj SpicyList::size() {
-    return SpicyObj(static_cast<double>(m_list.size()));
+    return SpicyObj(static_cast<int64_t>(length()));
 }
 
 std::string SpicyList::toString() {
     auto str = std::string{ "[" };
-    for (const auto& obj : m_list) {
-        str += getObjString(obj) + ", ";
+    for (auto i = size_t{0}; i < length(); ++i) {
+        str += getObjString(at(i)) + ", ";
     }
-    if (m_list.size() > 0) str.erase(str.length() - 2);
+    if (length() > 0) str.erase(str.length() - 2);
     return str + "]";
 }
 
 bool operator==(const SpicyList& lhs, const SpicyList& rhs) {
-    return lhs.m_list == rhs.m_list;
+    if (lhs.length() != rhs.length()) return false;
+    for (auto i = size_t{0}; i < lhs.length(); ++i) {
+        if (!(lhs.at(i) == rhs.at(i))) return false;
+    }
+    return true;
 }
 
 } // namespace spicy
@@ -3,11 +3,13 @@
 #define H_SPICYOBJECTS
 
 #include <optional>
-#include <map>
+#include <ostream>
 #include <memory>
+#include <span>
 #include <string>
 #include <variant>
-#include <deque>
+#include <unordered_map>
+#include <vector>
 
 #include "types.h"
 #include "spicyast.h"
@@ -15,52 +17,81 @@
 
 namespace spicy {
 
-class FuncObj;
-using FuncSharedPtr = std::shared_ptr<FuncObj>;
+[[nodiscard]]
+auto areEqual(const SpicyObj& lhs, const SpicyObj& rhs) -> bool;
 
-class BuiltinFunc;
-using BuiltinFuncSharedPtr = std::shared_ptr<BuiltinFunc>;
+[[nodiscard]]
+auto isTrue(const SpicyObj& obj) -> bool;
 
-class SpicyClass;
-using SpicyClassSharedPtr = std::shared_ptr<SpicyClass>;
+[[nodiscard]]
+auto getObjString(const SpicyObj& obj) -> std::string;
 
-class SpicyInstance;
-using SpicyInstanceSharedPtr = std::shared_ptr<SpicyInstance>;
+// same text as getObjString, strings are written out without a copy
+auto operator<<(std::ostream& out, const SpicyObj& obj) -> std::ostream&;
 
-class SpicyList;
-using SpicyListSharedPtr = std::shared_ptr<SpicyList>;
+/*
+ * Numbers are either 64-bit integers or doubles. Arithmetic on two integers is exact and stays in integers, it only
+ * gives a double when the result isn't a whole number or doesn't fit in 64 bits; anything involving a double is done
+ * in doubles. The operands have to be numbers, checking that is up to the caller.
+ */
+namespace numbers {
 
-using SpicyObj = std::variant<
-    std::string, double, bool, std::nullptr_t,
-    FuncSharedPtr, BuiltinFuncSharedPtr, SpicyClassSharedPtr,
-    SpicyInstanceSharedPtr, SpicyListSharedPtr>;
+[[nodiscard]] inline bool isNumber(const SpicyObj& obj) {
+    return obj.is<double>() || obj.is<int64_t>();
+}
 
-using OptSpicyObj = std::optional<SpicyObj>;
+[[nodiscard]] inline double toDouble(const SpicyObj& obj) {
+    return obj.is<double>() ? obj.as<double>() : static_cast<double>(obj.as<int64_t>());
+}
 
-[[nodiscard]]
-auto areEqual(const SpicyObj& lhs, const SpicyObj& rhs) -> bool;
+// doubles are truncated, for indexing
+[[nodiscard]] inline int64_t toInteger(const SpicyObj& obj) {
+    return obj.is<int64_t>() ? obj.as<int64_t>() : static_cast<int64_t>(obj.as<double>());
+}
 
-[[nodiscard]]
-auto isTrue(const SpicyObj& obj) -> bool;
+// the exact result, nullopt when it doesn't fit in 64 bits
+[[nodiscard]] std::optional<int64_t> checkedAdd(int64_t lhs, int64_t rhs);
+[[nodiscard]] std::optional<int64_t> checkedMultiply(int64_t lhs, int64_t rhs);
 
-[[nodiscard]]
-auto getObjString(const SpicyObj& obj) -> std::string;
+[[nodiscard]] SpicyObj add(const SpicyObj& lhs, const SpicyObj& rhs);
+[[nodiscard]] SpicyObj subtract(const SpicyObj& lhs, const SpicyObj& rhs);
+[[nodiscard]] SpicyObj multiply(const SpicyObj& lhs, const SpicyObj& rhs);
+[[nodiscard]] SpicyObj divide(const SpicyObj& lhs, const SpicyObj& rhs);
+[[nodiscard]] SpicyObj negate(const SpicyObj& obj);
+
+template <typename Compare>
+[[nodiscard]] bool compare(const SpicyObj& lhs, const SpicyObj& rhs) {
+    if (lhs.is<int64_t>() && rhs.is<int64_t>())
+        return Compare{}(lhs.as<int64_t>(), rhs.as<int64_t>());
+    return Compare{}(toDouble(lhs), toDouble(rhs));
+}
+
+} // namespace numbers
 
 namespace eval {
 class Environment;
+struct CompiledBody;
 }
 
-class Chunk;
+struct FuncBody;
+struct Upvalue;
 
-class FuncObj : public util::Uncopyable {
-    const ast::FuncExprPtr& m_decl;
+class FuncObj : public SpicyHeapObj {
+    const ast::FuncExprPtr* m_decl;     // nullptr for functions loaded as bytecode, they have no AST behind them
     const std::string m_funcName;
+    const size_t m_arity;
     std::shared_ptr<eval::Environment> m_closure;
     bool m_isMethod;
     bool m_isInit;
     
-    // TODO: for bytecode vm, improve this when moving bytecode gen to AST traversal instead of single pass Pratt parser
-    std::shared_ptr<Chunk> m_chunk;
+    // bytecode vm only: the body is shared by every closure created from the same declaration,
+    // the upvalues belong to this closure
+    std::shared_ptr<FuncBody> m_body;
+    std::vector<std::shared_ptr<Upvalue>> m_upvalues;
+    // closure-compiled evaluator only: the translated body, shared like m_body
+    std::shared_ptr<const eval::CompiledBody> m_compiled;
+    // methods taken off an instance as values, the receiver goes first in their frame when they're called
+    SpicyInstanceSharedPtr m_receiver;
 
 public:
     FuncObj(const ast::FuncExprPtr& decl,
@@ -68,6 +99,8 @@ public:
             std::shared_ptr<eval::Environment> closure,
             bool isMethod = false,
             bool isInit = false);
+    // bytecode vm only
+    FuncObj(const std::string& funcName, size_t arity, std::shared_ptr<FuncBody> body);
     
     [[nodiscard]] 
     auto arity()        const -> size_t;
@@ -85,46 +118,82 @@ public:
     auto isInit()       const -> bool;
     [[nodiscard]] 
     auto getParams()    const -> const std::vector<Token>&;
+    [[nodiscard]] 
+    auto getBody()      const -> const std::shared_ptr<FuncBody>&;
+    [[nodiscard]] 
+    auto getUpvalues()        -> std::vector<std::shared_ptr<Upvalue>>&;
+    [[nodiscard]] 
+    auto getCompiledBody() const -> const std::shared_ptr<const eval::CompiledBody>&;
+    [[nodiscard]] 
+    auto getReceiver()  const -> const SpicyInstanceSharedPtr&;
+    // the same method, bound to the given receiver
+    [[nodiscard]] 
+    auto bind(SpicyInstanceSharedPtr receiver) const -> FuncSharedPtr;
+    
+    void setBody(std::shared_ptr<FuncBody> body);
+    void setCompiledBody(std::shared_ptr<const eval::CompiledBody> body);
 };
 
-class BuiltinFunc : public util::Uncopyable {
+// Natives are stateless, the arguments are only borrowed for the duration of the call (in the vm they point
+// straight into its stack), so the same instance can be shared and called re-entrantly from anywhere.
+class BuiltinFunc : public SpicyHeapObj {
 protected:
-    std::string m_funcName = "";
-    std::shared_ptr<eval::Environment> m_closure;
-    std::vector<SpicyObj> m_args;
+    const std::string m_funcName;
 
 public:
-    BuiltinFunc(const std::string& funcName, std::shared_ptr<eval::Environment> closure = nullptr);
-
-    void setArgs(const std::vector<SpicyObj>& args);
+    explicit BuiltinFunc(const std::string& funcName);
+    virtual ~BuiltinFunc() = default;
 
-    virtual size_t arity() = 0;
-    virtual SpicyObj run() = 0;
-    std::string getFuncName() {
+    [[nodiscard]] virtual size_t arity() const = 0;
+    [[nodiscard]] virtual SpicyObj run(std::span<const SpicyObj> args) const = 0;
+    [[nodiscard]] const std::string& getFuncName() const {
         return m_funcName;
     }
 };
 
-class SpicyClass : public util::Uncopyable {
+class SpicyClass : public SpicyHeapObj {
 protected:
+    const uint64_t m_id;   // never reused, unlike addresses
     const std::string m_className;
     std::optional<SpicyClassSharedPtr> m_superClass;
-    std::hash<std::string> m_hasher;
-    std::map<size_t, SpicyObj> m_methods;
+    // every method the class answers to, inherited ones included, at their MethodIndex. nil where there's none
+    std::vector<SpicyObj> m_methods;
+    // the most fields an instance has had so far, new ones make room for that many up front
+    mutable size_t m_fieldCount = 0;
 
 public:
     SpicyClass(const std::string& name, std::optional<SpicyClassSharedPtr> superClass,
                const std::vector<std::pair<std::string, SpicyObj>>& methods);
 
+    [[nodiscard]] uint64_t getId() const;
     [[nodiscard]] std::string getClassName() const;
     [[nodiscard]] std::optional<SpicyClassSharedPtr> getSuperClass() const;
     [[nodiscard]] std::optional<SpicyObj> findMethod(const std::string& methodName) const;
+    [[nodiscard]] const SpicyObj* lookupMethod(MethodIndex index) const;
+    [[nodiscard]] size_t getFieldCount() const;
+    void noteFieldCount(size_t count) const;
 };
 
-class SpicyInstance : public util::Uncopyable {
+// The layout of an instance's fields, which name is in which slot. Instances that got the same fields in the same
+// order share one shape, reached by following the transitions from the empty one, so the shapes form a tree that
+// only grows: a program makes as many as it has distinct field layouts and they're never freed.
+class Shape : public util::Uncopyable {
+    std::vector<size_t> m_keys;   // hashed name of the field in each slot
+    mutable std::unordered_map<size_t, std::unique_ptr<Shape>> m_transitions;
+
+    explicit Shape(std::vector<size_t> keys);
+
+public:
+    [[nodiscard]] static const Shape* empty();
+    [[nodiscard]] std::optional<uint32_t> slotOf(size_t key) const;
+    // this shape with the field added in the next slot
+    [[nodiscard]] const Shape* withField(size_t key) const;
+};
+
+class SpicyInstance : public SpicyHeapObj {
     const SpicyClassSharedPtr m_class;
-    std::hash<std::string> m_hasher;
-    std::map<size_t, SpicyObj> m_fields;
+    const Shape* m_shape = Shape::empty();
+    std::vector<SpicyObj> m_slots;   // field values, laid out as m_shape says
 
 public:
     explicit SpicyInstance(SpicyClassSharedPtr class_);
@@ -132,12 +201,44 @@ public:
     [[nodiscard]] std::string toString() const;
     [[nodiscard]] SpicyObj get(const Token& fieldName) const;
     [[nodiscard]] SpicyObj get(const std::string& fieldName) const;
+    [[nodiscard]] SpicyObj get(const Token& fieldName, ast::PropertyCache& cache) const;
+    // the field the name resolves to through the cache, nullptr if there's none
+    [[nodiscard]] const SpicyObj* findField(ast::FieldCache& cache) const;
+    // the method of this instance's class the name resolves to, through the cache
+    [[nodiscard]] const SpicyObj& getMethod(const Token& name, ast::PropertyCache& cache) const;
+    [[nodiscard]] const SpicyClassSharedPtr& getClass() const;
     void set(const Token& fieldName, SpicyObj value);
+    void set(ast::FieldCache& cache, SpicyObj value);
+
+private:
+    void set(size_t key, SpicyObj value);
+    void updateCache(ast::FieldCache& cache) const;
 };
 
-class SpicyList : public util::Uncopyable {
-    std::deque<SpicyObj> m_list;
+// Elements are stored unboxed in one block, in the representation the first one picked: integers, doubles, bools as
+// packed bits, or plain values for everything else. An element that doesn't have that exact representation (a double
+// appended to integers, anything assigned over an element of another type) moves the whole list to plain values.
+class SpicyList : public SpicyHeapObj {
 public:
+    using Storage = std::variant<util::GapVector<SpicyObj>,
+                                 util::GapVector<int64_t>,
+                                 util::GapVector<double>,
+                                 util::GapVector<bool>>;
+
+private:
+    Storage m_items;
+
+    void insert(SpicyObj val, bool atFront);
+    void generalize();
+    [[nodiscard]] SpicyObj at(size_t idx) const;
+
+public:
+    SpicyList() : SpicyHeapObj(SpicyType::List) {}
+    explicit SpicyList(Storage items) : SpicyHeapObj(SpicyType::List), m_items(std::move(items)) {}
+
+    [[nodiscard]] size_t length() const;
+    [[nodiscard]] const Storage& storage() const { return m_items; }
+
     void append(const Token& lstName, SpicyObj val);
     void appendFront(const Token& lstName, SpicyObj val);
     SpicyObj get(const Token& lstName, int idx);
@@ -0,0 +1,411 @@
+#include "spicyoptimizer.h"
+#include "spicyobjects.h"
+
+#include <algorithm>
+#include <array>
+#include <string_view>
+#include <utility>
+#include <variant>
+
+namespace spicy::opt {
+
+namespace {
+
+// builtins that only look at their arguments, a call to anything else could change any variable or list
+constexpr auto pure_builtins = std::array<std::string_view, 6>{ "len", "sqrt", "sum", "dot", "min", "max" };
+
+bool isListLiteral(const ast::ExprPtrVariant& expr) {
+    if (!std::holds_alternative<ast::LiteralExprPtr>(expr)) return false;
+    const auto& literal = std::get<ast::LiteralExprPtr>(expr)->literalVal;
+    return literal.has_value()
+        && std::holds_alternative<std::string>(literal.value())
+        && std::get<std::string>(literal.value()) == "<spicy_list>";
+}
+
+bool containsReturn(const ast::StmtPtrVariant& stmt) {
+    if (std::holds_alternative<ast::RetStmtPtr>(stmt)) return true;
+    if (std::holds_alternative<ast::BlockStmtPtr>(stmt)) {
+        const auto& stmts = std::get<ast::BlockStmtPtr>(stmt)->statements;
+        return std::ranges::any_of(stmts, containsReturn);
+    }
+    if (std::holds_alternative<ast::IfStmtPtr>(stmt)) {
+        const auto& ifStmt = std::get<ast::IfStmtPtr>(stmt);
+        return containsReturn(ifStmt->thenBranch)
+            || (ifStmt->elseBranch.has_value() && containsReturn(ifStmt->elseBranch.value()));
+    }
+    if (std::holds_alternative<ast::WhileStmtPtr>(stmt)) {
+        return containsReturn(std::get<ast::WhileStmtPtr>(stmt)->loopBody);
+    }
+    // returns inside function declarations leave the function, not us
+    return false;
+}
+
+class LoopAnalyzer {
+public:
+    LoopAnalyzer(uint32_t loopDepth, const eval::ResolvedLocals& resolvedLocals,
+                 const std::set<std::string>& userGlobals, const HoistedExprs& hoisted)
+        : m_resolvedLocals(resolvedLocals), m_userGlobals(userGlobals), m_hoisted(hoisted),
+          m_loopDepth(loopDepth), m_depth(loopDepth) {}
+
+    auto analyze(const ast::WhileStmtPtr& loop) -> LoopInvariants {
+        scanExpr(loop->condition);
+        scanStmt(loop->loopBody);
+        // appends to a list the loop creates itself can't change the length of one that was there before it
+        m_resizesLists = std::ranges::any_of(m_appendTargets, [this](const auto& target) {
+            return !target.has_value() || !isFreshList(target.value());
+        });
+
+        LoopInvariants invariants;
+        m_depth = m_loopDepth;
+        collectExpr(loop->condition, invariants.condition);
+        auto stop = false;
+        collectStmt(loop->loopBody, invariants.body, stop);
+        return invariants;
+    }
+
+private:
+    using LocalId = std::pair<std::string, uint32_t>; // name and depth of the scope that declares it
+
+    [[nodiscard]] auto localId(ast::NodeId nodeId, const std::string& name) const -> std::optional<LocalId> {
+        const auto resolved = m_resolvedLocals.find(nodeId);
+        if (!resolved.has_value()) return std::nullopt;
+        return LocalId{ name, m_depth - resolved->distance };
+    }
+
+    // ========================================= side effects =========================================
+
+    void scanStmts(const std::vector<ast::StmtPtrVariant>& stmts) {
+        for (const auto& stmt : stmts) {
+            scanStmt(stmt);
+        }
+    }
+
+    void scanStmt(const ast::StmtPtrVariant& stmt) {
+        std::visit([this](const auto& node) { scan(node); }, stmt);
+    }
+
+    void scanExpr(const ast::ExprPtrVariant& expr) {
+        std::visit([this](const auto& node) { scan(node); }, expr);
+    }
+
+    void scan(const ast::ExprStmtPtr& stmt) {
+        if (stmt != nullptr) scanExpr(stmt->expression);
+    }
+    void scan(const ast::PrintStmtPtr& stmt) { scanExpr(stmt->expression); }
+    void scan(const ast::BlockStmtPtr& stmt) {
+        if (stmt->hasScope) m_depth++;
+        scanStmts(stmt->statements);
+        if (stmt->hasScope) m_depth--;
+    }
+    void scan(const ast::VarStmtPtr& stmt) {
+        if (stmt->initializer.has_value()) scanExpr(stmt->initializer.value());
+        const auto fresh = stmt->initializer.has_value() && isListLiteral(stmt->initializer.value());
+        declare(stmt->varName.lexeme, fresh);
+    }
+    void scan(const ast::IfStmtPtr& stmt) {
+        scanExpr(stmt->condition);
+        scanStmt(stmt->thenBranch);
+        if (stmt->elseBranch.has_value()) scanStmt(stmt->elseBranch.value());
+    }
+    void scan(const ast::WhileStmtPtr& stmt) {
+        scanExpr(stmt->condition);
+        scanStmt(stmt->loopBody);
+    }
+    // the body only runs when called, and calls are already treated as touching everything
+    void scan(const ast::FuncStmtPtr& stmt) { declare(stmt->funcName.lexeme, false); }
+    void scan(const ast::RetStmtPtr& stmt) {
+        if (stmt->value.has_value()) scanExpr(stmt->value.value());
+    }
+    void scan(const ast::ClassStmtPtr& stmt) {
+        declare(stmt->className.lexeme, false);
+        m_hasCalls = true;
+    }
+
+    void scan(const ast::BinaryExprPtr& expr) {
+        scanExpr(expr->left);
+        scanExpr(expr->right);
+        if (expr->op.type == TokenType::ARROW || expr->op.type == TokenType::RARROW) {
+            const auto& lst = expr->op.type == TokenType::ARROW ? expr->left : expr->right;
+            if (std::holds_alternative<ast::VariableExprPtr>(lst)) {
+                const auto& var = std::get<ast::VariableExprPtr>(lst);
+                m_appendTargets.emplace_back(localId(var->id, var->varName.lexeme));
+            } else {
+                m_appendTargets.emplace_back(std::nullopt);
+            }
+        }
+    }
+    void scan(const ast::GroupingExprPtr& expr) { scanExpr(expr->expression); }
+    void scan(const ast::LiteralExprPtr&) {}
+    void scan(const ast::UnaryExprPtr& expr) {
+        scanExpr(expr->right);
+        if ((expr->op.type == TokenType::PLUS_PLUS || expr->op.type == TokenType::MINUS_MINUS)
+            && std::holds_alternative<ast::VariableExprPtr>(expr->right)) {
+            const auto& var = std::get<ast::VariableExprPtr>(expr->right);
+            assign(var->id, var->varName.lexeme);
+        }
+    }
+    void scan(const ast::ConditionalExprPtr& expr) {
+        scanExpr(expr->condition);
+        scanExpr(expr->thenBranch);
+        scanExpr(expr->elseBranch);
+    }
+    void scan(const ast::PostfixExprPtr& expr) {
+        scanExpr(expr->left);
+        if (std::holds_alternative<ast::VariableExprPtr>(expr->left)) {
+            const auto& var = std::get<ast::VariableExprPtr>(expr->left);
+            assign(var->id, var->varName.lexeme);
+        }
+    }
+    void scan(const ast::VariableExprPtr&) {}
+    void scan(const ast::AssignExprPtr& expr) {
+        scanExpr(expr->right);
+        assign(expr->id, expr->varName.lexeme);
+    }
+    void scan(const ast::LogicalExprPtr& expr) {
+        scanExpr(expr->left);
+        scanExpr(expr->right);
+    }
+    void scan(const ast::CallExprPtr& expr) {
+        scanExpr(expr->callee);
+        for (const auto& arg : expr->arguments) {
+            scanExpr(arg);
+        }
+        if (!isPureBuiltin(expr->callee)) m_hasCalls = true;
+    }
+    void scan(const ast::FuncExprPtr&) {}
+    void scan(const ast::GetExprPtr& expr) {
+        scanExpr(expr->object);
+        m_hasCalls = true; // might be a method
+    }
+    void scan(const ast::SetExprPtr& expr) {
+        scanExpr(expr->object);
+        scanExpr(expr->value);
+        m_hasCalls = true;
+    }
+    void scan(const ast::ThisExprPtr&) {}
+    void scan(const ast::SuperExprPtr&) { m_hasCalls = true; }
+    void scan(const ast::IndexGetExprPtr& expr) {
+        scanExpr(expr->lst);
+        scanExpr(expr->idx);
+    }
+    void scan(const ast::IndexSetExprPtr& expr) {
+        scanExpr(expr->lst);
+        scanExpr(expr->idx);
+        scanExpr(expr->val);
+    }
+
+    void assign(ast::NodeId nodeId, const std::string& name) {
+        if (const auto id = localId(nodeId, name); id.has_value()) {
+            m_assignedLocals.insert(id.value());
+        } else {
+            m_assignedGlobals.insert(name);
+        }
+    }
+
+    void declare(const std::string& name, bool freshList) {
+        if (m_depth == 0) {
+            // a loop without a block around its body declares globals, over and over
+            m_assignedGlobals.insert(name);
+            return;
+        }
+        // two sibling blocks can declare the same name at the same depth, it's only fresh if all of them are
+        (freshList ? m_freshLists : m_otherLocals).insert(LocalId{ name, m_depth });
+    }
+
+    [[nodiscard]] bool isFreshList(const LocalId& id) const {
+        return m_freshLists.contains(id) && !m_otherLocals.contains(id) && !m_assignedLocals.contains(id);
+    }
+
+    // ========================================= invariance =========================================
+
+    [[nodiscard]] bool isPureBuiltin(const ast::ExprPtrVariant& callee) const {
+        if (!std::holds_alternative<ast::VariableExprPtr>(callee)) return false;
+        const auto& var = std::get<ast::VariableExprPtr>(callee);
+        const auto& name = var->varName.lexeme;
+        return !m_resolvedLocals.contains(var->id)
+            && !m_userGlobals.contains(name)
+            && !m_assignedGlobals.contains(name)
+            && std::ranges::find(pure_builtins, name) != pure_builtins.end();
+    }
+
+    [[nodiscard]] bool isInvariantRead(ast::NodeId nodeId, const std::string& name) const {
+        if (m_hasCalls) return false;
+        const auto id = localId(nodeId, name);
+        if (!id.has_value()) return !m_assignedGlobals.contains(name);
+        // anything declared inside the loop is a new variable on every iteration
+        return id->second <= m_loopDepth && !m_assignedLocals.contains(id.value());
+    }
+
+    [[nodiscard]] bool isInvariant(const ast::ExprPtrVariant& expr) const {
+        if (m_hoisted.contains(exprAddress(expr))) return true;
+        return std::visit([this, &expr](const auto& node) -> bool {
+            using T = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<T, ast::LiteralExprPtr>) {
+                // a list literal makes a new list every time it runs
+                return !isListLiteral(expr);
+            } else if constexpr (std::is_same_v<T, ast::GroupingExprPtr>) {
+                return isInvariant(node->expression);
+            } else if constexpr (std::is_same_v<T, ast::UnaryExprPtr>) {
+                return (node->op.type == TokenType::MINUS || node->op.type == TokenType::BANG)
+                    && isInvariant(node->right);
+            } else if constexpr (std::is_same_v<T, ast::BinaryExprPtr>) {
+                return node->op.type != TokenType::ARROW && node->op.type != TokenType::RARROW
+                    && isInvariant(node->left) && isInvariant(node->right);
+            } else if constexpr (std::is_same_v<T, ast::LogicalExprPtr>) {
+                return isInvariant(node->left) && isInvariant(node->right);
+            } else if constexpr (std::is_same_v<T, ast::VariableExprPtr>) {
+                return isInvariantRead(node->id, node->varName.lexeme);
+            } else if constexpr (std::is_same_v<T, ast::CallExprPtr>) {
+                if (!isPureBuiltin(node->callee)) return false;
+                if (std::get<ast::VariableExprPtr>(node->callee)->varName.lexeme == "len" && m_resizesLists) return false;
+                return std::ranges::all_of(node->arguments, [this](const auto& arg) { return isInvariant(arg); });
+            } else {
+                return false;
+            }
+        }, expr);
+    }
+
+    // not worth a slot, reading the hoisted value would cost just as much
+    [[nodiscard]] bool isCheap(const ast::ExprPtrVariant& expr) const {
+        if (m_hoisted.contains(exprAddress(expr))) return true;
+        if (std::holds_alternative<ast::LiteralExprPtr>(expr)) return true;
+        if (std::holds_alternative<ast::VariableExprPtr>(expr)) return m_resolvedLocals.contains(std::get<ast::VariableExprPtr>(expr)->id);
+        if (std::holds_alternative<ast::GroupingExprPtr>(expr)) return isCheap(std::get<ast::GroupingExprPtr>(expr)->expression);
+        return foldNumber(expr).has_value();
+    }
+
+    // ========================================= collection =========================================
+
+    void collectStmt(const ast::StmtPtrVariant& stmt, std::vector<const ast::ExprPtrVariant*>& out, bool& stop) {
+        if (stop) return;
+        std::visit([this, &out, &stop](const auto& node) {
+            using T = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<T, ast::ExprStmtPtr>) {
+                if (node != nullptr) collectExpr(node->expression, out);
+            } else if constexpr (std::is_same_v<T, ast::PrintStmtPtr>) {
+                collectExpr(node->expression, out);
+            } else if constexpr (std::is_same_v<T, ast::VarStmtPtr>) {
+                if (node->initializer.has_value()) collectExpr(node->initializer.value(), out);
+            } else if constexpr (std::is_same_v<T, ast::BlockStmtPtr>) {
+                if (node->hasScope) m_depth++;
+                for (const auto& inner : node->statements) {
+                    collectStmt(inner, out, stop);
+                }
+                if (node->hasScope) m_depth--;
+            } else if constexpr (std::is_same_v<T, ast::IfStmtPtr>) {
+                // the branches might not run, only the condition always does
+                collectExpr(node->condition, out);
+            } else if constexpr (std::is_same_v<T, ast::WhileStmtPtr>) {
+                collectExpr(node->condition, out);
+            } else if constexpr (std::is_same_v<T, ast::RetStmtPtr>) {
+                if (node->value.has_value()) collectExpr(node->value.value(), out);
+            } else if constexpr (std::is_same_v<T, ast::ClassStmtPtr>) {
+                stop = true;
+            }
+        }, stmt);
+        // whatever comes after a return might never run
+        if (containsReturn(stmt)) stop = true;
+    }
+
+    void collectExpr(const ast::ExprPtrVariant& expr, std::vector<const ast::ExprPtrVariant*>& out) {
+        if (isInvariant(expr)) {
+            if (!isCheap(expr)) out.push_back(&expr);
+            return;
+        }
+        // only descend where evaluation is unconditional, the right side of and/or might be skipped
+        std::visit([this, &out](const auto& node) {
+            using T = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<T, ast::BinaryExprPtr>) {
+                collectExpr(node->left, out);
+                collectExpr(node->right, out);
+            } else if constexpr (std::is_same_v<T, ast::GroupingExprPtr>) {
+                collectExpr(node->expression, out);
+            } else if constexpr (std::is_same_v<T, ast::UnaryExprPtr>) {
+                collectExpr(node->right, out);
+            } else if constexpr (std::is_same_v<T, ast::ConditionalExprPtr>) {
+                collectExpr(node->condition, out);
+            } else if constexpr (std::is_same_v<T, ast::AssignExprPtr>) {
+                collectExpr(node->right, out);
+            } else if constexpr (std::is_same_v<T, ast::LogicalExprPtr>) {
+                collectExpr(node->left, out);
+            } else if constexpr (std::is_same_v<T, ast::CallExprPtr>) {
+                collectExpr(node->callee, out);
+                for (const auto& arg : node->arguments) {
+                    collectExpr(arg, out);
+                }
+            } else if constexpr (std::is_same_v<T, ast::IndexGetExprPtr>) {
+                collectExpr(node->lst, out);
+                collectExpr(node->idx, out);
+            } else if constexpr (std::is_same_v<T, ast::IndexSetExprPtr>) {
+                collectExpr(node->lst, out);
+                collectExpr(node->idx, out);
+                collectExpr(node->val, out);
+            }
+        }, expr);
+    }
+
+private:
+    const eval::ResolvedLocals& m_resolvedLocals;
+    const std::set<std::string>& m_userGlobals;
+    const HoistedExprs& m_hoisted;
+    const uint32_t m_loopDepth;
+    uint32_t m_depth;
+
+    std::set<std::string> m_assignedGlobals;
+    std::set<LocalId> m_assignedLocals;
+    std::set<LocalId> m_freshLists;
+    std::set<LocalId> m_otherLocals;
+    std::vector<std::optional<LocalId>> m_appendTargets; // nullopt when it isn't a local variable
+    bool m_hasCalls = false;
+    bool m_resizesLists = false;
+};
+
+} // namespace
+
+auto exprAddress(const ast::ExprPtrVariant& expr) -> uint64_t {
+    return std::visit([](const auto& node) { return reinterpret_cast<uint64_t>(node.get()); }, expr);
+}
+
+auto foldNumber(const ast::ExprPtrVariant& expr) -> std::optional<SpicyObj> {
+    if (std::holds_alternative<ast::LiteralExprPtr>(expr)) {
+        const auto& literal = std::get<ast::LiteralExprPtr>(expr);
+        if (numbers::isNumber(literal->value)) {
+            return literal->value;
+        }
+        return std::nullopt;
+    }
+    if (std::holds_alternative<ast::GroupingExprPtr>(expr)) {
+        return foldNumber(std::get<ast::GroupingExprPtr>(expr)->expression);
+    }
+    if (std::holds_alternative<ast::UnaryExprPtr>(expr)) {
+        const auto& unary = std::get<ast::UnaryExprPtr>(expr);
+        if (unary->op.type != TokenType::MINUS) return std::nullopt;
+        const auto right = foldNumber(unary->right);
+        return right.has_value() ? std::optional(numbers::negate(right.value())) : std::nullopt;
+    }
+    if (std::holds_alternative<ast::BinaryExprPtr>(expr)) {
+        const auto& binary = std::get<ast::BinaryExprPtr>(expr);
+        const auto op = binary->op.type;
+        if (op != TokenType::PLUS && op != TokenType::MINUS && op != TokenType::STAR && op != TokenType::SLASH) {
+            return std::nullopt;
+        }
+        const auto left = foldNumber(binary->left);
+        if (!left.has_value()) return std::nullopt;
+        const auto right = foldNumber(binary->right);
+        if (!right.has_value()) return std::nullopt;
+        switch (op) {
+        case TokenType::PLUS:   return numbers::add(left.value(), right.value());
+        case TokenType::MINUS:  return numbers::subtract(left.value(), right.value());
+        case TokenType::STAR:   return numbers::multiply(left.value(), right.value());
+        default:                return numbers::divide(left.value(), right.value());
+        }
+    }
+    return std::nullopt;
+}
+
+auto findLoopInvariants(const ast::WhileStmtPtr& loop, uint32_t scopeDepth, const eval::ResolvedLocals& resolvedLocals,
+                        const std::set<std::string>& userGlobals, const HoistedExprs& hoisted) -> LoopInvariants {
+    return LoopAnalyzer(scopeDepth, resolvedLocals, userGlobals, hoisted).analyze(loop);
+}
+
+} // namespace spicy::opt
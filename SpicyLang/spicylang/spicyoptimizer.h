@@ -0,0 +1,48 @@
+#pragma once
+#ifndef H_SPICYOPTIMIZER
+#define H_SPICYOPTIMIZER
+
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "spicyast.h"
+#include "spicyresolver.h"
+
+namespace spicy::opt {
+
+// the AST side tables are keyed on the address of the node an expression variant holds
+[[nodiscard]]
+auto exprAddress(const ast::ExprPtrVariant& expr) -> uint64_t;
+
+// value of an expression made only of number literals and arithmetic, if it is one
+[[nodiscard]]
+auto foldNumber(const ast::ExprPtrVariant& expr) -> std::optional<SpicyObj>;
+
+// hoisted expressions and the local slot their value lives in
+using HoistedExprs = std::map<uint64_t, uint8_t>;
+
+// expressions a loop can compute once instead of on every iteration, in the order they have to be evaluated
+struct LoopInvariants {
+    std::vector<const ast::ExprPtrVariant*> condition;  // safe to evaluate before the first test
+    std::vector<const ast::ExprPtrVariant*> body;       // only safe once the loop is known to run
+};
+
+/*
+ * Finds the pure expressions of a while loop whose value can't change from one iteration to the next.
+ * This is deliberately conservative, a loop that calls anything but a known pure builtin, or declares globals,
+ * gets nothing hoisted besides constants. Only spots that run on every iteration are considered, so hoisting
+ * never evaluates something the loop wouldn't have evaluated itself.
+ *
+ * scopeDepth is the depth the loop statement sits at, userGlobals the globals the program declares itself
+ * (which might shadow a builtin) and hoisted the expressions an enclosing loop already took care of.
+ */
+[[nodiscard]]
+auto findLoopInvariants(const ast::WhileStmtPtr& loop, uint32_t scopeDepth, const eval::ResolvedLocals& resolvedLocals,
+                        const std::set<std::string>& userGlobals, const HoistedExprs& hoisted) -> LoopInvariants;
+
+} // namespace spicy::opt
+
+#endif // H_SPICYOPTIMIZER
@@ -2,7 +2,8 @@
 
 namespace spicy {
 
-SpicyParser::SpicyParser(const std::vector<Token>& tokens) : m_tokens(tokens) {
+SpicyParser::SpicyParser(const std::vector<Token>& tokens, ast::NodeId firstNodeId)
+    : m_tokens(tokens), m_nextNodeId(firstNodeId) {
     m_current = 0;
 }
 
@@ -14,6 +15,10 @@ std::optional<ast::ExprPtrVariant> SpicyParser::parseExpr() {
     }
 }
 
+ast::NodeId SpicyParser::nextNodeId() const {
+    return m_nextNodeId;
+}
+
 ast::SpicyProgram SpicyParser::parseProgram() {
     auto stmts = std::vector<ast::StmtPtrVariant>{};
     try {
@@ -37,8 +42,8 @@ ast::ExprPtrVariant SpicyParser::assignment() {
         const auto equals = previous();
         auto value = assignment();
         if (std::holds_alternative<ast::VariableExprPtr>(expr)) {
-            const auto& name = std::get<ast::VariableExprPtr>(expr)->varName;
-            return ast::createAssignEPV(name, std::move(value));
+            const auto& var = std::get<ast::VariableExprPtr>(expr);
+            return ast::createAssignEPV(var->varName, std::move(value), var->id);
         } else if (std::holds_alternative<ast::GetExprPtr>(expr)) {
             const auto& get = std::get<ast::GetExprPtr>(expr);
             return ast::createSetEPV(std::move(get->object), get->name, std::move(value));
@@ -151,7 +156,7 @@ ast::ExprPtrVariant SpicyParser::chain() {
         
         auto tok = Token(TokenType::IDENTIFIER, "__anon__no__collide", std::nullopt, pipe.line);
         auto args_ = std::vector<ast::ExprPtrVariant>{};
-        args_.emplace_back(ast::createVarEPV(tok));
+        args_.emplace_back(ast::createVarEPV(tok, newNodeId()));
         
         auto expr2 = ast::createCallEPV(expression(), pipe, std::move(args_));
         auto args = std::vector<ast::ExprPtrVariant>{};
@@ -202,7 +207,7 @@ ast::ExprPtrVariant SpicyParser::primary()
         const auto keyword = previous();
         consume(TokenType::DOT, "Expect '.' after 'super'.");
         const auto method = consume(TokenType::IDENTIFIER, "Expect superclass method name.");
-        return ast::createSuperEPV(keyword, method);
+        return ast::createSuperEPV(keyword, method, newNodeId());
     }
 
     if (match(TokenType::FUN) || match(TokenType::BACKSLASH)) {
@@ -210,11 +215,11 @@ ast::ExprPtrVariant SpicyParser::primary()
     }
 
     if (match(TokenType::THIS)) {
-        return ast::createThisEPV(previous());
+        return ast::createThisEPV(previous(), newNodeId());
     }
 
     if (match(TokenType::IDENTIFIER)) {
-        return ast::createVarEPV(previous());
+        return ast::createVarEPV(previous(), newNodeId());
     }
 
     if (match(TokenType::LEFT_PAREN)) {
@@ -419,7 +424,7 @@ ast::StmtPtrVariant SpicyParser::classDeclaration() {
     std::optional<ast::ExprPtrVariant> superClass = std::nullopt;
     if (match(TokenType::COLON)) {
         consume(TokenType::IDENTIFIER, "Expect superclass name.");
-        superClass = ast::createVarEPV(previous());
+        superClass = ast::createVarEPV(previous(), newNodeId());
     }
     consume(TokenType::LEFT_BRACE, "Expect '{' before class body.");
     std::vector<ast::FuncStmtPtr> methods;
@@ -493,6 +498,10 @@ Token SpicyParser::consume(TokenType tokenType, const std::string &msg) {
     throw error(peek(), msg);
 }
 
+ast::NodeId SpicyParser::newNodeId() {
+    return m_nextNodeId++;
+}
+
 SpicyParser::ParseError SpicyParser::error(Token token, const std::string &msg) {
     spicy::error(token, msg);
     return ParseError{};
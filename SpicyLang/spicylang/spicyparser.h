@@ -30,14 +30,17 @@ class SpicyParser
     static constexpr auto MAX_ARGS = 255;
     std::vector<Token> m_tokens;
     uint32_t m_current = 0;
+    ast::NodeId m_nextNodeId;
 
 public:
-    explicit SpicyParser(const std::vector<Token>& tokens);
+    // ids start at firstNodeId so that programs parsed piece by piece (the repl) don't reuse them
+    explicit SpicyParser(const std::vector<Token>& tokens, ast::NodeId firstNodeId = 0);
 
     class ParseError : std::exception {};
 
     std::optional<ast::ExprPtrVariant> parseExpr();
     ast::SpicyProgram parseProgram();
+    [[nodiscard]] ast::NodeId nextNodeId() const;
 private:
     ast::ExprPtrVariant expression();
     ast::ExprPtrVariant assignment();
@@ -78,6 +81,7 @@ private:
     Token previous();
     [[nodiscard]] Token peek();
     Token consume(TokenType tokenType, const std::string& msg);
+    ast::NodeId newNodeId();
 
     ParseError error(Token token, const std::string& msg);
     void synchronize();
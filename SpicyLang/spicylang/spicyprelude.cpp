@@ -0,0 +1,42 @@
+#include "spicyprelude.h"
+
+#include <format>
+
+#include "spicy.h"
+#include "spicypreludedata.h"
+#include "spicyserializer.h"
+
+namespace spicy::prelude {
+
+auto chunk() -> const Chunk& {
+    static const auto prelude = []() {
+        if (bytecode.empty()) return Chunk{};
+        auto decoded = deserializeChunk(bytecode);
+        if (!decoded.has_value()) {
+            error(0, "Unable to load the prelude, its bytecode is corrupted or out of date.");
+            return Chunk{};
+        }
+        return std::move(decoded.value());
+    }();
+    return prelude;
+}
+
+void writeHeader(std::ostream& out, std::span<const uint8_t> bytecode) {
+    out << "// Generated from prelude.spicy by `SpicyLang --emit-prelude`, do not edit.\n";
+    out << "#pragma once\n";
+    out << "#ifndef H_SPICYPRELUDEDATA\n";
+    out << "#define H_SPICYPRELUDEDATA\n\n";
+    out << "#include <array>\n";
+    out << "#include <cstdint>\n\n";
+    out << "namespace spicy::prelude {\n\n";
+    out << std::format("constexpr auto bytecode = std::array<uint8_t, {}>{{", bytecode.size());
+    for (auto i = 0ull; i < bytecode.size(); ++i) {
+        out << (i % 16 == 0 ? "\n    " : " ");
+        out << std::format("0x{:02x},", bytecode[i]);
+    }
+    out << "\n};\n\n";
+    out << "} // namespace spicy::prelude\n\n";
+    out << "#endif // H_SPICYPRELUDEDATA\n";
+}
+
+} // namespace spicy::prelude
@@ -0,0 +1,27 @@
+#pragma once
+#ifndef H_SPICYPRELUDE
+#define H_SPICYPRELUDE
+
+#include <cstdint>
+#include <ostream>
+#include <span>
+
+#include "vmtypes.h"
+
+namespace spicy::prelude {
+
+/*
+ * The prelude is a Spicy script (prelude.spicy) compiled ahead of time and embedded in the binary as bytecode,
+ * the vm runs it before every script to define its globals without scanning or parsing anything.
+ */
+
+// decoded once, an empty chunk if the embedded bytecode is missing or unreadable
+[[nodiscard]]
+auto chunk() -> const Chunk&;
+
+// writes the C++ header holding the given bytecode, the way spicypreludedata.h gets generated
+void writeHeader(std::ostream& out, std::span<const uint8_t> bytecode);
+
+} // namespace spicy::prelude
+
+#endif // H_SPICYPRELUDE
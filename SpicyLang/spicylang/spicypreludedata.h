@@ -0,0 +1,107 @@
+// Generated from prelude.spicy by `SpicyLang --emit-prelude`, do not edit.
+#pragma once
+#ifndef H_SPICYPRELUDEDATA
+#define H_SPICYPRELUDEDATA
+
+#include <array>
+#include <cstdint>
+
+namespace spicy::prelude {
+
+constexpr auto bytecode = std::array<uint8_t, 1444>{
+    0x53, 0x50, 0x43, 0x59, 0x02, 0x2f, 0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x08, 0x01, 0x1f, 0x02,
+    0x00, 0x08, 0x03, 0x1f, 0x04, 0x00, 0x08, 0x05, 0x1f, 0x06, 0x00, 0x08, 0x07, 0x1f, 0x08, 0x00,
+    0x08, 0x09, 0x1f, 0x0a, 0x00, 0x08, 0x0b, 0x1f, 0x0c, 0x00, 0x08, 0x0d, 0x1f, 0x0e, 0x00, 0x08,
+    0x0f, 0x1f, 0x10, 0x00, 0x08, 0x11, 0x01, 0x21, 0x09, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00,
+    0x05, 0x00, 0x00, 0x00, 0x0b, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
+    0x05, 0x00, 0x00, 0x00, 0x1e, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00,
+    0x05, 0x00, 0x00, 0x00, 0x2f, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x36, 0x00, 0x00, 0x00,
+    0x05, 0x00, 0x00, 0x00, 0x3d, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x45, 0x00, 0x00, 0x00,
+    0x07, 0x00, 0x00, 0x00, 0x12, 0x00, 0x00, 0x00, 0x04, 0x07, 0x00, 0x00, 0x00, 0x66, 0x6f, 0x72,
+    0x45, 0x61, 0x63, 0x68, 0x02, 0x28, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0x03, 0x07, 0x01, 0x05,
+    0x01, 0x1c, 0x01, 0x11, 0x1a, 0x00, 0x16, 0x04, 0x05, 0x02, 0x05, 0x01, 0x05, 0x03, 0x28, 0x1c,
+    0x01, 0x04, 0x05, 0x03, 0x00, 0x02, 0x12, 0x06, 0x03, 0x04, 0x1b, 0x00, 0x22, 0x04, 0x04, 0x01,
+    0x21, 0x03, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x0f, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00,
+    0x00, 0x0a, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x0f, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00,
+    0x00, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x03, 0x00, 0x00, 0x00, 0x6c,
+    0x65, 0x6e, 0x05, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x07, 0x00, 0x00, 0x00,
+    0x66, 0x6f, 0x72, 0x45, 0x61, 0x63, 0x68, 0x04, 0x03, 0x00, 0x00, 0x00, 0x6d, 0x61, 0x70, 0x02,
+    0x2f, 0x00, 0x00, 0x00, 0x25, 0x00, 0x00, 0x05, 0x04, 0x07, 0x01, 0x05, 0x01, 0x1c, 0x01, 0x11,
+    0x1a, 0x00, 0x19, 0x04, 0x05, 0x03, 0x05, 0x02, 0x05, 0x01, 0x05, 0x04, 0x28, 0x1c, 0x01, 0x26,
+    0x04, 0x05, 0x04, 0x00, 0x02, 0x12, 0x06, 0x04, 0x04, 0x1b, 0x00, 0x25, 0x04, 0x04, 0x05, 0x03,
+    0x21, 0x01, 0x21, 0x05, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x0d,
+    0x00, 0x00, 0x00, 0x0f, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x0d,
+    0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x03,
+    0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x03, 0x00, 0x00,
+    0x00, 0x6c, 0x65, 0x6e, 0x05, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x03, 0x00,
+    0x00, 0x00, 0x6d, 0x61, 0x70, 0x04, 0x04, 0x00, 0x00, 0x00, 0x6d, 0x61, 0x70, 0x32, 0x03, 0x4d,
+    0x00, 0x00, 0x00, 0x25, 0x07, 0x00, 0x05, 0x01, 0x1c, 0x01, 0x07, 0x00, 0x05, 0x02, 0x1c, 0x01,
+    0x0f, 0x16, 0x1a, 0x00, 0x07, 0x04, 0x05, 0x04, 0x21, 0x19, 0x00, 0x01, 0x04, 0x00, 0x01, 0x05,
+    0x05, 0x07, 0x00, 0x05, 0x01, 0x1c, 0x01, 0x11, 0x1a, 0x00, 0x1e, 0x04, 0x05, 0x04, 0x05, 0x03,
+    0x05, 0x01, 0x05, 0x05, 0x28, 0x05, 0x02, 0x05, 0x05, 0x28, 0x1c, 0x02, 0x26, 0x04, 0x05, 0x05,
+    0x00, 0x02, 0x12, 0x06, 0x05, 0x04, 0x1b, 0x00, 0x2a, 0x04, 0x04, 0x05, 0x04, 0x21, 0x01, 0x21,
+    0x07, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x15, 0x00, 0x00, 0x00,
+    0x12, 0x00, 0x00, 0x00, 0x16, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00,
+    0x0f, 0x00, 0x00, 0x00, 0x19, 0x00, 0x00, 0x00, 0x12, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00,
+    0x0d, 0x00, 0x00, 0x00, 0x1b, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,
+    0x03, 0x03, 0x00, 0x00, 0x00, 0x6c, 0x65, 0x6e, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x05, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x04, 0x00, 0x00, 0x00, 0x6d,
+    0x61, 0x70, 0x32, 0x04, 0x06, 0x00, 0x00, 0x00, 0x66, 0x69, 0x6c, 0x74, 0x65, 0x72, 0x02, 0x3c,
+    0x00, 0x00, 0x00, 0x25, 0x00, 0x00, 0x05, 0x04, 0x07, 0x01, 0x05, 0x01, 0x1c, 0x01, 0x11, 0x1a,
+    0x00, 0x26, 0x04, 0x05, 0x02, 0x05, 0x01, 0x05, 0x04, 0x28, 0x1c, 0x01, 0x1a, 0x00, 0x0d, 0x04,
+    0x05, 0x03, 0x05, 0x01, 0x05, 0x04, 0x28, 0x26, 0x04, 0x19, 0x00, 0x01, 0x04, 0x05, 0x04, 0x00,
+    0x02, 0x12, 0x06, 0x04, 0x04, 0x1b, 0x00, 0x32, 0x04, 0x04, 0x05, 0x03, 0x21, 0x01, 0x21, 0x06,
+    0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x0f,
+    0x00, 0x00, 0x00, 0x21, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x22, 0x00, 0x00, 0x00, 0x0d,
+    0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x25, 0x00, 0x00, 0x00, 0x05,
+    0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x03, 0x03, 0x00, 0x00, 0x00, 0x6c, 0x65, 0x6e, 0x05, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x03, 0x06, 0x00, 0x00, 0x00, 0x66, 0x69, 0x6c, 0x74, 0x65, 0x72, 0x04, 0x04, 0x00, 0x00,
+    0x00, 0x66, 0x6f, 0x6c, 0x64, 0x03, 0x2f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0x04, 0x07, 0x01,
+    0x05, 0x01, 0x1c, 0x01, 0x11, 0x1a, 0x00, 0x1a, 0x04, 0x05, 0x03, 0x05, 0x01, 0x05, 0x04, 0x28,
+    0x05, 0x02, 0x1c, 0x02, 0x06, 0x02, 0x04, 0x05, 0x04, 0x00, 0x02, 0x12, 0x06, 0x04, 0x04, 0x1b,
+    0x00, 0x26, 0x04, 0x04, 0x05, 0x02, 0x21, 0x01, 0x21, 0x04, 0x00, 0x00, 0x00, 0x29, 0x00, 0x00,
+    0x00, 0x0f, 0x00, 0x00, 0x00, 0x2a, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x00, 0x00, 0x29, 0x00, 0x00,
+    0x00, 0x0d, 0x00, 0x00, 0x00, 0x2c, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00,
+    0x00, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x03, 0x00, 0x00, 0x00, 0x6c,
+    0x65, 0x6e, 0x05, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x04, 0x00, 0x00, 0x00,
+    0x66, 0x6f, 0x6c, 0x64, 0x04, 0x03, 0x00, 0x00, 0x00, 0x61, 0x6e, 0x79, 0x02, 0x33, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x05, 0x03, 0x07, 0x01, 0x05, 0x01, 0x1c, 0x01, 0x11, 0x1a, 0x00, 0x1f, 0x04,
+    0x05, 0x02, 0x05, 0x01, 0x05, 0x03, 0x28, 0x1c, 0x01, 0x1a, 0x00, 0x06, 0x04, 0x02, 0x21, 0x19,
+    0x00, 0x01, 0x04, 0x05, 0x03, 0x00, 0x02, 0x12, 0x06, 0x03, 0x04, 0x1b, 0x00, 0x2b, 0x04, 0x04,
+    0x03, 0x21, 0x01, 0x21, 0x04, 0x00, 0x00, 0x00, 0x30, 0x00, 0x00, 0x00, 0x0f, 0x00, 0x00, 0x00,
+    0x31, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x30, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00,
+    0x33, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x03, 0x00, 0x00, 0x00, 0x6c, 0x65, 0x6e, 0x05, 0x01, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x03, 0x00, 0x00, 0x00, 0x61, 0x6e, 0x79, 0x04, 0x03,
+    0x00, 0x00, 0x00, 0x61, 0x6c, 0x6c, 0x02, 0x34, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0x03, 0x07,
+    0x01, 0x05, 0x01, 0x1c, 0x01, 0x11, 0x1a, 0x00, 0x20, 0x04, 0x05, 0x02, 0x05, 0x01, 0x05, 0x03,
+    0x28, 0x1c, 0x01, 0x16, 0x1a, 0x00, 0x06, 0x04, 0x03, 0x21, 0x19, 0x00, 0x01, 0x04, 0x05, 0x03,
+    0x00, 0x02, 0x12, 0x06, 0x03, 0x04, 0x1b, 0x00, 0x2c, 0x04, 0x04, 0x02, 0x21, 0x01, 0x21, 0x04,
+    0x00, 0x00, 0x00, 0x37, 0x00, 0x00, 0x00, 0x0f, 0x00, 0x00, 0x00, 0x38, 0x00, 0x00, 0x00, 0x14,
+    0x00, 0x00, 0x00, 0x37, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x3a, 0x00, 0x00, 0x00, 0x04,
+    0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x03, 0x03, 0x00, 0x00, 0x00, 0x6c, 0x65, 0x6e, 0x05, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x03, 0x03, 0x00, 0x00, 0x00, 0x61, 0x6c, 0x6c, 0x04, 0x07, 0x00, 0x00, 0x00, 0x72, 0x65,
+    0x76, 0x65, 0x72, 0x73, 0x65, 0x01, 0x2e, 0x00, 0x00, 0x00, 0x25, 0x00, 0x00, 0x07, 0x01, 0x05,
+    0x03, 0x05, 0x04, 0x05, 0x01, 0x1c, 0x01, 0x11, 0x1a, 0x00, 0x15, 0x04, 0x05, 0x01, 0x05, 0x03,
+    0x28, 0x05, 0x02, 0x27, 0x04, 0x05, 0x03, 0x00, 0x02, 0x12, 0x06, 0x03, 0x04, 0x1b, 0x00, 0x21,
+    0x04, 0x04, 0x04, 0x05, 0x02, 0x21, 0x01, 0x21, 0x05, 0x00, 0x00, 0x00, 0x3e, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x3f, 0x00, 0x00, 0x00, 0x11, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00,
+    0x09, 0x00, 0x00, 0x00, 0x3f, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x00, 0x00, 0x42, 0x00, 0x00, 0x00,
+    0x05, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x03, 0x03, 0x00, 0x00, 0x00, 0x6c, 0x65, 0x6e, 0x05, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x03, 0x07, 0x00, 0x00, 0x00, 0x72, 0x65, 0x76, 0x65, 0x72, 0x73, 0x65, 0x04, 0x05,
+    0x00, 0x00, 0x00, 0x72, 0x61, 0x6e, 0x67, 0x65, 0x02, 0x24, 0x00, 0x00, 0x00, 0x25, 0x05, 0x01,
+    0x05, 0x04, 0x05, 0x02, 0x11, 0x1a, 0x00, 0x12, 0x04, 0x05, 0x03, 0x05, 0x04, 0x26, 0x04, 0x05,
+    0x04, 0x00, 0x00, 0x12, 0x06, 0x04, 0x04, 0x1b, 0x00, 0x1a, 0x04, 0x04, 0x05, 0x03, 0x21, 0x01,
+    0x21, 0x05, 0x00, 0x00, 0x00, 0x46, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x47, 0x00, 0x00,
+    0x00, 0x0b, 0x00, 0x00, 0x00, 0x48, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x47, 0x00, 0x00,
+    0x00, 0x0d, 0x00, 0x00, 0x00, 0x4a, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00,
+    0x00, 0x05, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x05, 0x00, 0x00, 0x00, 0x72,
+    0x61, 0x6e, 0x67, 0x65,
+};
+
+} // namespace spicy::prelude
+
+#endif // H_SPICYPRELUDEDATA
@@ -2,12 +2,13 @@
 
 #include "spicy.h"
 
+#include <algorithm>
 #include <utility>
 
 namespace spicy::eval {
 
-SpicyResolver::SpicyResolver(SpicyEvaluator &evaluator)
-    : m_evaluator(evaluator) {}
+SpicyResolver::SpicyResolver(ResolvedLocals &locals)
+    : m_locals(locals) {}
 
 void SpicyResolver::resolve(const std::vector<ast::StmtPtrVariant> &stmts) {
     for (const auto& stmt : stmts)
@@ -15,6 +16,15 @@ void SpicyResolver::resolve(const std::vector<ast::StmtPtrVariant> &stmts) {
 }
 
 void SpicyResolver::resolveBlockStmt(const ast::BlockStmtPtr &stmt) {
+    stmt->hasScope = std::ranges::any_of(stmt->statements, [](const auto& inner) {
+        return std::holds_alternative<ast::VarStmtPtr>(inner)
+            || std::holds_alternative<ast::FuncStmtPtr>(inner)
+            || std::holds_alternative<ast::ClassStmtPtr>(inner);
+    });
+    if (!stmt->hasScope) {
+        resolve(stmt->statements);
+        return;
+    }
     beginScope();
     resolve(stmt->statements);
     endScope();
@@ -55,6 +65,8 @@ void SpicyResolver::resolveRetStmt(const ast::RetStmtPtr &stmt) {
         if (m_currentFunction == FunctionType::INITIALIZER)
             error(stmt->ret, "Cannot return a value from an initializer.");
         resolve(stmt->value.value());
+        stmt->isTailCall = m_currentFunction != FunctionType::NONE
+                           && std::holds_alternative<ast::CallExprPtr>(stmt->value.value());
     }
 }
 
@@ -78,18 +90,15 @@ void SpicyResolver::resolveClassStmt(const ast::ClassStmtPtr &stmt) {
         m_currentClass = ClassType::SUBCLASS;
         resolve(stmt->superClass.value());
         beginScope();
-        m_scopes.back().insert_or_assign(m_hasher("super"), true);
+        addVar("super", true);
     }
 
-    beginScope();
-    m_scopes.back().insert_or_assign(m_hasher("this"), true);
     for (const auto& method : stmt->methods) {
         auto decl = FunctionType::METHOD;
         if (method->funcName.lexeme == "init")
             decl = FunctionType::INITIALIZER;
         resolveFunction(method, decl);
     }
-    endScope();
 
     if (hasSuperClass) endScope();
     m_currentClass = enclosingClass;
@@ -97,17 +106,18 @@ void SpicyResolver::resolveClassStmt(const ast::ClassStmtPtr &stmt) {
 
 void SpicyResolver::resolveVarExpr(const ast::VariableExprPtr &expr) {
     if (!m_scopes.empty()) {
-        if (const auto found = m_scopes.back().find(m_hasher(expr->varName.lexeme));
-            found != m_scopes.back().end() && !found->second) {
+        const auto& vars = m_scopes.back().vars;
+        if (const auto found = vars.find(m_hasher(expr->varName.lexeme));
+            found != vars.end() && !found->second.isDefined) {
             error(expr->varName, "Can't read local variable in its own initializer");
         }
     }
-    resolveLocal(reinterpret_cast<uint64_t>(expr.get()), expr->varName);
+    resolveLocal(expr->id, expr->varName);
 }
 
 void SpicyResolver::resolveAssignExpr(const ast::AssignExprPtr &expr) {
     resolve(expr->right);
-    resolveLocal(reinterpret_cast<uint64_t>(expr.get()), expr->varName);
+    resolveLocal(expr->id, expr->varName);
 }
 
 void SpicyResolver::resolveBinaryExpr(const ast::BinaryExprPtr &expr) {
@@ -159,7 +169,7 @@ void SpicyResolver::resolveThisExpr(const ast::ThisExprPtr &expr) {
         error(expr->keyword, "Cannot use 'this' outside of a class.");
         return;
     }
-    resolveLocal(reinterpret_cast<uint64_t>(expr.get()), expr->keyword);
+    resolveLocal(expr->id, expr->keyword);
 }
 
 void SpicyResolver::resolveSuperExpr(const ast::SuperExprPtr &expr) {
@@ -170,7 +180,7 @@ void SpicyResolver::resolveSuperExpr(const ast::SuperExprPtr &expr) {
         throw RuntimeError(expr->keyword,
                            "Cannot use 'super' in a class with no superclass.");
     }
-    resolveLocal(reinterpret_cast<uint64_t>(expr.get()), expr->keyword);
+    resolveLocal(expr->id, expr->keyword);
 }
 
 void SpicyResolver::resolveIndexGetExpr(const ast::IndexGetExprPtr& expr) {
@@ -228,15 +238,19 @@ void SpicyResolver::resolve(const ast::ExprPtrVariant &expr) {
     std::visit(ExprResolverVisitor(this), expr);
 }
 
-void SpicyResolver::resolveLocal(uint64_t exprAddr, Token name) {
-    resolveLocal(exprAddr, name.lexeme);
+void SpicyResolver::resolveLocal(ast::NodeId id, Token name) {
+    resolveLocal(id, name.lexeme);
 }
 
-void SpicyResolver::resolveLocal(uint64_t exprAddr, const std::string& name) {
+void SpicyResolver::resolveLocal(ast::NodeId id, const std::string& name) {
     for (auto i = m_scopes.size(); i > 0; --i) {
-        if (const auto& scope = m_scopes[i - 1].find(m_hasher(name));
-            scope != m_scopes[i - 1].end()) {
-            m_evaluator.resolve(exprAddr, m_scopes.size() - i);
+        const auto& vars = m_scopes[i - 1].vars;
+        if (const auto& var = vars.find(m_hasher(name));
+            var != vars.end()) {
+            m_locals.insert(id, ResolvedLocal{
+                .distance = static_cast<uint32_t>(m_scopes.size() - i),
+                .slot = var->second.slot
+            });
             return;
         }
     }
@@ -246,6 +260,9 @@ void SpicyResolver::resolveFunction(const ast::FuncStmtPtr &stmt, FunctionType t
     beginScope();
     const auto previousFunction = m_currentFunction;
     m_currentFunction = type;
+    // a method's receiver comes first in its frame, ahead of the parameters
+    if (type == FunctionType::METHOD || type == FunctionType::INITIALIZER)
+        addVar("this", true);
     for (const auto& param : stmt->funcExpr->parameters) {
         declare(param);
         define(param);
@@ -278,12 +295,19 @@ void SpicyResolver::endScope() {
 
 void SpicyResolver::declare(Token name) {
     if (m_scopes.empty()) return;
-    m_scopes.back().insert_or_assign(m_hasher(name.lexeme), false);
+    addVar(name.lexeme, false);
 }
 
 void SpicyResolver::define(Token name) {
     if (m_scopes.empty()) return;
-    m_scopes.back().insert_or_assign(m_hasher(name.lexeme), true);
+    m_scopes.back().vars.at(m_hasher(name.lexeme)).isDefined = true;
+}
+
+// every declaration gets a new slot, even one shadowing a name already in the scope,
+// so that slots keep matching the order in which the evaluator defines variables
+void SpicyResolver::addVar(const std::string& name, bool isDefined) {
+    auto& scope = m_scopes.back();
+    scope.vars.insert_or_assign(m_hasher(name), ScopedVar{ .slot = scope.slotCount++, .isDefined = isDefined });
 }
 
 } // namespace spicy
@@ -3,12 +3,38 @@
 
 #include <memory>
 #include <map>
+#include <optional>
 #include <vector>
 
-#include "spicyeval.h"
+#include "spicyast.h"
 
 namespace spicy::eval {
 
+// where a local lives: how many scopes up from its use it was declared, and its slot in that scope.
+// Slots are handed out in declaration order, which is also the order the evaluator defines them in.
+struct ResolvedLocal {
+    uint32_t distance;
+    uint32_t slot;
+};
+
+// what each variable-naming expression refers to, indexed by the id the parser gave it.
+// Globals are left out of the table.
+class ResolvedLocals {
+    std::vector<std::optional<ResolvedLocal>> m_locals;
+
+public:
+    void insert(ast::NodeId id, ResolvedLocal local) {
+        if (id >= m_locals.size()) m_locals.resize(id + 1);
+        m_locals[id] = local;
+    }
+    [[nodiscard]] std::optional<ResolvedLocal> find(ast::NodeId id) const {
+        return id < m_locals.size() ? m_locals[id] : std::nullopt;
+    }
+    [[nodiscard]] bool contains(ast::NodeId id) const {
+        return find(id).has_value();
+    }
+};
+
 enum class FunctionType {
     NONE,
     FUNCTION,
@@ -24,13 +50,22 @@ enum class ClassType {
 };
 
 class SpicyResolver {
-    SpicyEvaluator& m_evaluator;
-    std::vector<std::map<size_t, bool>> m_scopes;
+    struct ScopedVar {
+        uint32_t slot;
+        bool isDefined;
+    };
+    struct Scope {
+        std::map<size_t, ScopedVar> vars;
+        uint32_t slotCount = 0;
+    };
+
+    ResolvedLocals& m_locals;
+    std::vector<Scope> m_scopes;
     std::hash<std::string> m_hasher;
     ClassType m_currentClass = ClassType::NONE;
     FunctionType m_currentFunction = FunctionType::NONE;
 public:
-    explicit SpicyResolver(SpicyEvaluator& evaluator);
+    explicit SpicyResolver(ResolvedLocals& locals);
 
     void resolve(const std::vector<ast::StmtPtrVariant>& stmts);
     void resolve(const ast::StmtPtrVariant& stmt);
@@ -64,8 +99,8 @@ private:
     void resolveIndexSetExpr(const ast::IndexSetExprPtr& expr);
 
     void resolve(const ast::ExprPtrVariant& expr);
-    void resolveLocal(uint64_t exprAddr, Token name);
-    void resolveLocal(uint64_t exprAddr, const std::string& name);
+    void resolveLocal(ast::NodeId id, Token name);
+    void resolveLocal(ast::NodeId id, const std::string& name);
     void resolveFunction(const ast::FuncStmtPtr& stmt, FunctionType type = FunctionType::FUNCTION);
     void resolveLambda(const ast::FuncExprPtr& expr);
 
@@ -73,6 +108,7 @@ private:
     void endScope();
     void declare(Token name);
     void define(Token name);
+    void addVar(const std::string& name, bool isDefined);
 
     friend struct StmtResolverVisitor;
     friend struct ExprResolverVisitor;
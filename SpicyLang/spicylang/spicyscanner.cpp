@@ -2,6 +2,8 @@
 #include "spicyscanner.h"
 
 #include <cctype>
+#include <charconv>
+#include <system_error>
 
 namespace spicy {
 
@@ -152,8 +154,18 @@ void SpicyScanner::scanNumber() {
     if (peek() == '.' && isDigit(peekNext())) {
         advance();
         while (isDigit(peek())) advance();
+        addToken(TokenType::NUMBER, std::stod(m_source.substr(m_start, m_current - m_start)));
+        return;
+    }
+
+    // no fractional part, it's an integer unless it's too big for one
+    auto value = int64_t{0};
+    const auto* first = m_source.data() + m_start;
+    const auto* last = m_source.data() + m_current;
+    if (std::from_chars(first, last, value).ec == std::errc{}) {
+        addToken(TokenType::NUMBER, value);
+        return;
     }
-    
     addToken(TokenType::NUMBER, std::stod(m_source.substr(m_start, m_current - m_start)));
 }
 
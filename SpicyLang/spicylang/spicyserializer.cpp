@@ -0,0 +1,237 @@
+#include "spicyserializer.h"
+
+#include <array>
+#include <bit>
+#include <string>
+#include <utility>
+
+namespace spicy {
+
+namespace {
+
+constexpr auto magic = std::array<uint8_t, 4>{ 'S', 'P', 'C', 'Y' };
+constexpr uint8_t format_version = 2;
+
+enum class ConstantTag : uint8_t {
+    NIL,
+    BOOLEAN,
+    NUMBER,
+    STRING,
+    FUNCTION,
+    INTEGER
+};
+
+class ChunkWriter {
+    std::vector<uint8_t> m_out;
+
+public:
+    auto finish() -> std::vector<uint8_t> { return std::move(m_out); }
+
+    void u8(uint8_t value) { m_out.push_back(value); }
+
+    void u32(uint32_t value) {
+        for (auto i = 0; i < 4; ++i) {
+            u8(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    void u64(uint64_t value) {
+        for (auto i = 0; i < 8; ++i) {
+            u8(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    void f64(double value) {
+        u64(std::bit_cast<uint64_t>(value));
+    }
+
+    void str(const std::string& value) {
+        u32(static_cast<uint32_t>(value.size()));
+        m_out.insert(m_out.end(), value.begin(), value.end());
+    }
+
+    [[nodiscard]] bool chunk(const Chunk& chunk) {
+        const auto& code = chunk.getBytecode();
+        u32(static_cast<uint32_t>(code.size()));
+        m_out.insert(m_out.end(), code.begin(), code.end());
+
+        // lines as (line, instruction bytes) runs, the same thing the chunk keeps in memory
+        auto runs = std::vector<std::pair<uint32_t, uint32_t>>{};
+        for (auto offset = 0ull; offset < code.size(); ++offset) {
+            const auto line = chunk.getLine(offset);
+            if (runs.empty() || runs.back().first != line) runs.emplace_back(line, 0);
+            runs.back().second++;
+        }
+        u32(static_cast<uint32_t>(runs.size()));
+        for (const auto& [line, count] : runs) {
+            u32(line);
+            u32(count);
+        }
+
+        const auto& constants = chunk.getConstants();
+        u32(static_cast<uint32_t>(constants.size()));
+        for (const auto& constant : constants) {
+            if (!this->constant(constant)) return false;
+        }
+        return true;
+    }
+
+    [[nodiscard]] bool constant(const SpicyObj& obj) {
+        if (obj.is<std::nullptr_t>()) {
+            u8(static_cast<uint8_t>(ConstantTag::NIL));
+        } else if (obj.is<bool>()) {
+            u8(static_cast<uint8_t>(ConstantTag::BOOLEAN));
+            u8(obj.as<bool>() ? 1 : 0);
+        } else if (obj.is<double>()) {
+            u8(static_cast<uint8_t>(ConstantTag::NUMBER));
+            f64(obj.as<double>());
+        } else if (obj.is<int64_t>()) {
+            u8(static_cast<uint8_t>(ConstantTag::INTEGER));
+            u64(static_cast<uint64_t>(obj.as<int64_t>()));
+        } else if (obj.is<std::string>()) {
+            u8(static_cast<uint8_t>(ConstantTag::STRING));
+            str(obj.as<std::string>());
+        } else if (obj.is<FuncSharedPtr>()) {
+            const auto func = obj.as<FuncSharedPtr>();
+            auto& body = *func->getBody();
+            if (!body.isCompiled() && !std::exchange(body.compileBody, nullptr)(body.chunk)) {
+                return false;
+            }
+            u8(static_cast<uint8_t>(ConstantTag::FUNCTION));
+            str(func->getFuncName());
+            u8(static_cast<uint8_t>(func->arity()));
+            return chunk(body.chunk);
+        } else {
+            // lists, classes and the like are only ever created at runtime
+            return false;
+        }
+        return true;
+    }
+};
+
+class ChunkReader {
+    std::span<const uint8_t> m_data;
+    size_t m_pos = 0;
+    bool m_failed = false;
+
+public:
+    explicit ChunkReader(std::span<const uint8_t> data) : m_data(data) {}
+
+    [[nodiscard]] bool failed() const { return m_failed; }
+    [[nodiscard]] bool atEnd() const { return m_pos == m_data.size(); }
+
+    uint8_t u8() {
+        if (m_pos >= m_data.size()) {
+            m_failed = true;
+            return 0;
+        }
+        return m_data[m_pos++];
+    }
+
+    uint32_t u32() {
+        auto value = 0u;
+        for (auto i = 0; i < 4; ++i) {
+            value |= static_cast<uint32_t>(u8()) << (8 * i);
+        }
+        return value;
+    }
+
+    uint64_t u64() {
+        auto value = 0ull;
+        for (auto i = 0; i < 8; ++i) {
+            value |= static_cast<uint64_t>(u8()) << (8 * i);
+        }
+        return value;
+    }
+
+    double f64() {
+        return std::bit_cast<double>(u64());
+    }
+
+    std::string str() {
+        const auto size = u32();
+        if (m_failed || m_data.size() - m_pos < size) {
+            m_failed = true;
+            return {};
+        }
+        auto value = std::string(reinterpret_cast<const char*>(m_data.data() + m_pos), size);
+        m_pos += size;
+        return value;
+    }
+
+    std::optional<Chunk> chunk() {
+        const auto codeSize = u32();
+        if (m_failed || m_data.size() - m_pos < codeSize) return std::nullopt;
+        const auto code = m_data.subspan(m_pos, codeSize);
+        m_pos += codeSize;
+
+        auto chunk = Chunk{};
+        auto offset = 0u;
+        const auto runCount = u32();
+        for (auto i = 0u; i < runCount && !m_failed; ++i) {
+            const auto line = u32();
+            const auto count = u32();
+            if (count > code.size() - offset) return std::nullopt;
+            for (auto j = 0u; j < count; ++j) {
+                chunk.appendByte(code[offset++], static_cast<int>(line));
+            }
+        }
+        if (m_failed || offset != code.size()) return std::nullopt;
+
+        const auto constantCount = u32();
+        for (auto i = 0u; i < constantCount && !m_failed; ++i) {
+            auto value = constant();
+            if (!value.has_value()) return std::nullopt;
+            std::ignore = chunk.addConstant(std::move(value.value()));
+        }
+        if (m_failed) return std::nullopt;
+        return chunk;
+    }
+
+    std::optional<SpicyObj> constant() {
+        switch (static_cast<ConstantTag>(u8())) {
+        case ConstantTag::NIL:      return SpicyObj{ nullptr };
+        case ConstantTag::BOOLEAN:  return SpicyObj{ u8() != 0 };
+        case ConstantTag::NUMBER:   return SpicyObj{ f64() };
+        case ConstantTag::INTEGER:  return SpicyObj{ static_cast<int64_t>(u64()) };
+        case ConstantTag::STRING:   return SpicyObj{ StringObj::intern(str()) };
+        case ConstantTag::FUNCTION: {
+            auto name = str();
+            const auto arity = u8();
+            auto body = std::make_shared<FuncBody>();
+            auto bodyChunk = chunk();
+            if (!bodyChunk.has_value()) return std::nullopt;
+            body->chunk = std::move(bodyChunk.value());
+            return SpicyObj{ makeRef<FuncObj>(name, arity, std::move(body)) };
+        }
+        default:
+            m_failed = true;
+            return std::nullopt;
+        }
+    }
+};
+
+} // namespace
+
+auto serializeChunk(const Chunk& chunk) -> std::optional<std::vector<uint8_t>> {
+    auto writer = ChunkWriter{};
+    for (const auto byte : magic) {
+        writer.u8(byte);
+    }
+    writer.u8(format_version);
+    if (!writer.chunk(chunk)) return std::nullopt;
+    return writer.finish();
+}
+
+auto deserializeChunk(std::span<const uint8_t> data) -> std::optional<Chunk> {
+    auto reader = ChunkReader(data);
+    for (const auto byte : magic) {
+        if (reader.u8() != byte) return std::nullopt;
+    }
+    if (reader.u8() != format_version) return std::nullopt;
+    auto chunk = reader.chunk();
+    if (reader.failed() || !reader.atEnd()) return std::nullopt;
+    return chunk;
+}
+
+} // namespace spicy
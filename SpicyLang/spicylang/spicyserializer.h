@@ -0,0 +1,27 @@
+#pragma once
+#ifndef H_SPICYSERIALIZER
+#define H_SPICYSERIALIZER
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "vmtypes.h"
+
+namespace spicy {
+
+/*
+ * Binary form of a compiled chunk, used to ship precompiled bytecode inside the binary (see spicyprelude.h).
+ * Function constants are written out with their whole body, bodies that haven't been compiled yet are
+ * compiled on the spot. Numbers are stored little-endian whatever the host is.
+ */
+[[nodiscard]]
+auto serializeChunk(const Chunk& chunk) -> std::optional<std::vector<uint8_t>>;
+
+[[nodiscard]]
+auto deserializeChunk(std::span<const uint8_t> data) -> std::optional<Chunk>;
+
+} // namespace spicy
+
+#endif // H_SPICYSERIALIZER
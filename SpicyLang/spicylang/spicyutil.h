@@ -2,6 +2,13 @@
 #ifndef H_SPICYUTIL
 #define H_SPICYUTIL
 
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 namespace spicy::util {
     
 // thanks aakshintala on github :)    
@@ -14,6 +21,45 @@ struct Uncopyable {
     auto operator=(Uncopyable&&) -> Uncopyable& = delete;
 };
 
+// A vector that also keeps spare room in front of its elements, so that pushing at either end is amortized
+// constant time while the elements stay in one contiguous block.
+template <typename T>
+class GapVector {
+    std::vector<T> m_items;   // the first m_begin are unused
+    size_t m_begin = 0;
+
+public:
+    using value_type = T;
+
+    GapVector() = default;
+    explicit GapVector(std::vector<T> items) : m_items(std::move(items)) {}
+
+    [[nodiscard]] size_t size() const { return m_items.size() - m_begin; }
+    [[nodiscard]] bool empty() const { return size() == 0; }
+    [[nodiscard]] decltype(auto) operator[](size_t idx) { return m_items[m_begin + idx]; }
+    [[nodiscard]] decltype(auto) operator[](size_t idx) const { return m_items[m_begin + idx]; }
+
+    [[nodiscard]] std::span<const T> span() const requires (!std::is_same_v<T, bool>) {
+        return { m_items.data() + m_begin, size() };
+    }
+
+    void reserve(size_t count) { m_items.reserve(m_begin + count); }
+    void pushBack(T value) { m_items.push_back(std::move(value)); }
+    void pushFront(T value) {
+        if (m_begin == 0) {
+            // as much room in front as there are elements, the same growth push_back gets
+            const auto gap = std::max<size_t>(size(), 4);
+            auto items = std::vector<T>(gap);
+            items.reserve(gap + m_items.size());
+            for (auto i = size_t{0}; i < m_items.size(); ++i)
+                items.push_back(std::move(m_items[i]));
+            m_items = std::move(items);
+            m_begin = gap;
+        }
+        m_items[--m_begin] = std::move(value);
+    }
+};
+
 }
 
 #endif
@@ -1,47 +1,62 @@
 #include "spicyvm.h"
 #include "spicy.h"
+#include "spicybuiltins.h"
+#include "spicyprelude.h"
 
 #include <iostream>
 #include <format>
 
 namespace spicy {
-    SpicyVM::SpicyVM(bool trace_execution, bool is_repl) 
+    SpicyVM::SpicyVM(bool trace_execution, bool is_repl)
         : trace_execution(trace_execution), is_repl(is_repl) {
         reset(false);
     }
-    
+
     void SpicyVM::disassemble(const Chunk& chunk) {
         chunk.disassemble("TODO");
     }
-    
+
     // TODO: return type for status?
     void SpicyVM::execute(const Chunk& chunk) {
         reset(is_repl);
-        
+        if (!prelude_loaded) {
+            prelude_loaded = true;
+            runChunk(prelude::chunk());
+        }
+        runChunk(chunk);
+    }
+
+    void SpicyVM::runChunk(const Chunk& chunk) {
+        // the script occupies slot 0 like any other callee would
+        push(nullptr);
+        frames.emplace_back(CallFrame{ .closure = nullptr, .chunk = &chunk, .instructionPtr = 0, .slots = 0 });
+        run();
+    }
+
+    void SpicyVM::run() {
+        auto* frame = &frames.back();
+
         auto binary = [&](auto op) {
-            if (!std::holds_alternative<double>(peek(0)) ||
-                !std::holds_alternative<double>(peek(1))) {
-                runtimeError("Operands must be numbers.", chunk);
+            if (!numbers::isNumber(peek(0)) ||
+                !numbers::isNumber(peek(1))) {
+                runtimeError("Operands must be numbers.");
                 return false;
             }
             auto&& b = pop();
             auto&& a = pop();
-            push(op(std::get<double>(a), std::get<double>(b)));
+            push(op(a, b));
             return true;
         };
-        
-        while (program_counter < chunk.getBytecodeCount()) {
+
+        while (true) {
             if (trace_execution) {
                 printStack();
-                auto discarded = chunk.disassembleInstruction(program_counter);
+                auto discarded = frame->chunk->disassembleInstruction(frame->instructionPtr);
             }
-            switch (static_cast<Chunk::OpCode>(readByte(chunk))) {
-            case Chunk::OpCode::OP_CONSTANT: {
-                const auto& constants = chunk.getConstants();
-                const auto& obj = constants[readByte(chunk)];
-                push(obj);
+            switch (static_cast<Chunk::OpCode>(readByte())) {
+            case Chunk::OpCode::OP_CONSTANT:
+                push(readConstant());
                 break;
-            }
             case Chunk::OpCode::OP_NIL:
                 push(nullptr);
                 break;
@@ -52,11 +67,11 @@ namespace spicy {
                 push(false);
                 break;
             case Chunk::OpCode::OP_NEGATE: {
-                if (!std::holds_alternative<double>(peek(0))) {
-                    runtimeError("Operand must be a number.", chunk);
+                if (!numbers::isNumber(peek(0))) {
+                    runtimeError("Operand must be a number.");
                     return;
                 }
-                push(-std::get<double>(pop()));
+                push(numbers::negate(pop()));
                 break;
             }
             case Chunk::OpCode::OP_NOT:
@@ -66,41 +81,48 @@ namespace spicy {
                 pop();
                 break;
             case Chunk::OpCode::OP_DEFINE_GLOBAL: {
-                const auto& constants = chunk.getConstants();
-                const auto& name = std::get<std::string>(constants[readByte(chunk)]);
-                const auto val = peek(0);
-                globals.insert({ name, val });
+                globals.insert_or_assign(readConstant().as<StringSharedPtr>(), peek(0));
                 pop();
                 break;
             }
             case Chunk::OpCode::OP_GET_GLOBAL: {
-                const auto& constants = chunk.getConstants();
-                const auto& name = std::get<std::string>(constants[readByte(chunk)]);
-                if (!globals.contains(name)) {
-                    runtimeError(std::format("Undefined variable {}.", name), chunk);
+                const auto name = readConstant().as<StringSharedPtr>();
+                const auto global = globals.find(name);
+                if (global == globals.end()) {
+                    runtimeError(std::format("Undefined variable {}.", name->str()));
                     return;
                 }
-                push(globals[name]);
+                push(global->second);
                 break;
             }
             case Chunk::OpCode::OP_SET_GLOBAL: {
-                const auto& constants = chunk.getConstants();
-                const auto& name = std::get<std::string>(constants[readByte(chunk)]);
-                if (!globals.contains(name)) {
-                    runtimeError(std::format("Undefined variable [{}].", name), chunk);
+                const auto name = readConstant().as<StringSharedPtr>();
+                const auto global = globals.find(name);
+                if (global == globals.end()) {
+                    runtimeError(std::format("Undefined variable [{}].", name->str()));
                     return;
                 }
-                globals[name] = peek(0);
+                global->second = peek(0);
                 break;
             }
             case Chunk::OpCode::OP_GET_LOCAL: {
-                const auto slot = readByte(chunk);
-                push(stack[current_stack][slot]);
+                const auto slot = readByte();
+                push(stack[frame->slots + slot]);
                 break;
             }
             case Chunk::OpCode::OP_SET_LOCAL: {
-                const auto slot = readByte(chunk);
-                stack[current_stack][slot] = peek(0);
+                const auto slot = readByte();
+                stack[frame->slots + slot] = peek(0);
+                break;
+            }
+            case Chunk::OpCode::OP_GET_UPVALUE: {
+                const auto slot = readByte();
+                push(upvalueRef(frame->closure->getUpvalues()[slot]));
+                break;
+            }
+            case Chunk::OpCode::OP_SET_UPVALUE: {
+                const auto slot = readByte();
+                upvalueRef(frame->closure->getUpvalues()[slot]) = peek(0);
                 break;
             }
             case Chunk::OpCode::OP_EQUAL: {
@@ -110,112 +132,312 @@ namespace spicy {
                 break;
             }
             case Chunk::OpCode::OP_GREATER:
-                if (!binary([](double a, double b) { return a > b; })) return;
+                if (!binary(numbers::compare<std::greater<>>)) return;
                 break;
             case Chunk::OpCode::OP_LESS:
-                if (!binary([](double a, double b) { return a < b; })) return;
+                if (!binary(numbers::compare<std::less<>>)) return;
                 break;
             case Chunk::OpCode::OP_ADD: {
-                if (std::holds_alternative<std::string>(peek(0)) &&
-                    std::holds_alternative<std::string>(peek(1))) {
+                if (peek(0).is<std::string>() &&
+                    peek(1).is<std::string>()) {
                     auto&& b = pop();
                     auto&& a = pop();
-                    push(std::move(std::get<std::string>(a) + std::get<std::string>(b)));
-                } else if (std::holds_alternative<double>(peek(0)) &&
-                    std::holds_alternative<double>(peek(1))) {
+                    push(StringObj::concat(a.as<StringSharedPtr>(), b.as<StringSharedPtr>()));
+                } else if (peek(0).is<double>() &&
+                    peek(1).is<double>()) {
                     auto&& b = pop();
                     auto&& a = pop();
-                    push(std::move(std::get<double>(a) + std::get<double>(b)));
+                    push(std::move(a.as<double>() + b.as<double>()));
+                } else if (numbers::isNumber(peek(0)) &&
+                    numbers::isNumber(peek(1))) {
+                    auto&& b = pop();
+                    auto&& a = pop();
+                    push(numbers::add(a, b));
                 } else {
-                    runtimeError("Operands must be either numbers or strings.", chunk);
+                    runtimeError("Operands must be either numbers or strings.");
                     return;
                 }
                 break;
             }
-            case Chunk::OpCode::OP_SUBTRACT: 
-                if (!binary([](double a, double b) { return a - b; })) return;
+            case Chunk::OpCode::OP_SUBTRACT:
+                if (!binary(numbers::subtract)) return;
                 break;
             case Chunk::OpCode::OP_MULTIPLY:
-                if (!binary([](double a, double b) { return a * b; })) return;
+                if (!binary(numbers::multiply)) return;
                 break;
             case Chunk::OpCode::OP_DIVIDE:
-                if (!binary([](double a, double b) { return a / b; })) return;
+                if (!binary(numbers::divide)) return;
                 break;
             case Chunk::OpCode::OP_PRINT:
-                std::cout << '\n' << getObjString(pop()) << '\n';
+                std::cout << pop() << '\n';
                 break;
             case Chunk::OpCode::OP_JUMP: {
-                program_counter += readShort(chunk);
+                const auto offset = readShort();
+                frame->instructionPtr += offset;
                 break;
             }
             case Chunk::OpCode::OP_JUMP_IF_FALSE: {
-                auto offset = readShort(chunk);
+                const auto offset = readShort();
                 if (!isTrue(peek(0))) {
-                    program_counter += offset;
+                    frame->instructionPtr += offset;
                 }
                 break;
             }
             case Chunk::OpCode::OP_LOOP: {
-                auto offset = readShort(chunk);
-                program_counter -= offset;
+                const auto offset = readShort();
+                frame->instructionPtr -= offset;
+                break;
+            }
+            case Chunk::OpCode::OP_CALL: {
+                const auto argCount = readByte();
+                if (!callValue(peek(argCount), argCount)) return;
+                frame = &frames.back();
+                break;
+            }
+            case Chunk::OpCode::OP_CLOSURE: {
+                const auto proto = readConstant().as<FuncSharedPtr>();
+                auto closure = makeRef<FuncObj>(proto->getFuncName(), proto->arity(), proto->getBody());
+                const auto upvalueCount = readByte();
+                auto& upvalues = closure->getUpvalues();
+                upvalues.reserve(upvalueCount);
+                for (auto i = 0; i < upvalueCount; ++i) {
+                    const auto isLocal = readByte();
+                    const auto index = readByte();
+                    upvalues.emplace_back(isLocal
+                        ? captureUpvalue(frame->slots + index)
+                        : frame->closure->getUpvalues()[index]);
+                }
+                push(std::move(closure));
+                break;
+            }
+            case Chunk::OpCode::OP_CLOSE_UPVALUE:
+                closeUpvalues(stack.size() - 1);
+                pop();
+                break;
+            case Chunk::OpCode::OP_RETURN: {
+                auto result = pop();
+                closeUpvalues(frame->slots);
+                const auto slots = frame->slots;
+                frames.pop_back();
+                stack.erase(stack.begin() + slots, stack.end());
+                if (frames.empty()) {
+                    return;
+                }
+                push(std::move(result));
+                frame = &frames.back();
+                break;
+            }
+            case Chunk::OpCode::OP_LIST:
+                push(makeRef<SpicyList>());
+                break;
+            case Chunk::OpCode::OP_APPEND: {
+                if (!peek(1).is<SpicyListSharedPtr>()) {
+                    runtimeError("Can only append elements to lists.");
+                    return;
+                }
+                auto val = pop();
+                try {
+                    peek(0).as<SpicyListSharedPtr>()->append(Token{}, std::move(val));
+                } catch (const RuntimeError& err) {
+                    runtimeError(err.what());
+                    return;
+                }
+                break;
+            }
+            case Chunk::OpCode::OP_PREPEND: {
+                if (!peek(0).is<SpicyListSharedPtr>()) {
+                    runtimeError("Can only append elements to lists.");
+                    return;
+                }
+                auto lst = pop();
+                auto val = pop();
+                try {
+                    lst.as<SpicyListSharedPtr>()->appendFront(Token{}, std::move(val));
+                } catch (const RuntimeError& err) {
+                    runtimeError(err.what());
+                    return;
+                }
+                push(std::move(lst));
+                break;
+            }
+            case Chunk::OpCode::OP_GET_INDEX: {
+                if (!peek(1).is<SpicyListSharedPtr>()) {
+                    runtimeError("Can only perform indexing operations on lists.");
+                    return;
+                }
+                if (!numbers::isNumber(peek(0))) {
+                    runtimeError("Index expression must evaluate to a number.");
+                    return;
+                }
+                const auto idx = static_cast<int>(numbers::toInteger(pop()));
+                const auto lst = pop();
+                try {
+                    push(lst.as<SpicyListSharedPtr>()->get(Token{}, idx));
+                } catch (const RuntimeError& err) {
+                    runtimeError(err.what());
+                    return;
+                }
+                break;
+            }
+            case Chunk::OpCode::OP_SET_INDEX: {
+                if (!peek(2).is<SpicyListSharedPtr>()) {
+                    runtimeError("Can only perform indexing operations on lists.");
+                    return;
+                }
+                if (!numbers::isNumber(peek(1))) {
+                    runtimeError("Index expression must evaluate to a number.");
+                    return;
+                }
+                auto val = pop();
+                const auto idx = static_cast<int>(numbers::toInteger(pop()));
+                try {
+                    std::ignore = peek(0).as<SpicyListSharedPtr>()->set(Token{}, idx, std::move(val));
+                } catch (const RuntimeError& err) {
+                    runtimeError(err.what());
+                    return;
+                }
                 break;
             }
-            case Chunk::OpCode::OP_RETURN:
-                //std::cout << '\n' << getObjString(pop()) << '\n';
+            default:
+                runtimeError("Unknown opcode.");
                 return;
             }
         }
     }
-    
+
     void SpicyVM::reset(bool is_repl) {
-        current_stack = 0l;
-        program_counter = 0l;
-        if (is_repl) { return; }
-        
         stack.clear();
-        stack.emplace_back(Stack<SpicyObj>{});
+        frames.clear();
+        frames.reserve(frames_max);
+        open_upvalues.clear();
+        if (is_repl) { return; }
+
         globals.clear();
+        for (const auto& builtin : getBuiltins()) {
+            globals.insert_or_assign(StringObj::intern(builtin->getFuncName()), builtin);
+        }
+        prelude_loaded = false;
     }
-    
-    uint8_t SpicyVM::readByte(const Chunk& chunk) {
-		const auto& code = chunk.getBytecode();
-        return code[program_counter++];
+
+    uint8_t SpicyVM::readByte() {
+        auto& frame = frames.back();
+        return frame.chunk->getBytecode()[frame.instructionPtr++];
     }
 
-    uint16_t SpicyVM::readShort(const Chunk& chunk) {
-        const auto& code = chunk.getBytecode();
-        auto b1 = code[program_counter++];
-        auto b2 = code[program_counter++];
+    uint16_t SpicyVM::readShort() {
+        auto& frame = frames.back();
+        const auto& code = frame.chunk->getBytecode();
+        auto b1 = code[frame.instructionPtr++];
+        auto b2 = code[frame.instructionPtr++];
         return static_cast<uint16_t>((b1 << 8) | b2);
     }
-    
+
+    const SpicyObj& SpicyVM::readConstant() {
+        const auto idx = readByte();
+        return frames.back().chunk->getConstants()[idx];
+    }
+
     void SpicyVM::push(SpicyObj value) {
-        stack[current_stack].emplace_back(std::move(value));
+        stack.emplace_back(std::move(value));
     }
-    
+
     SpicyObj SpicyVM::pop() {
-        if (stack[current_stack].empty()) return {};
-        
-        const auto value = stack[current_stack].back();
-        stack[current_stack].pop_back();
+        if (stack.empty()) return {};
+
+        auto value = std::move(stack.back());
+        stack.pop_back();
         return value;
     }
 
     SpicyObj& SpicyVM::peek(int distance) {
-        const auto top = stack[current_stack].size() - 1;
-        return stack[current_stack][top - distance];
+        const auto top = stack.size() - 1;
+        return stack[top - distance];
+    }
+
+    bool SpicyVM::callValue(const SpicyObj& callee, uint8_t argCount) {
+        if (callee.is<BuiltinFuncSharedPtr>()) {
+            return callNative(*callee.as<BuiltinFuncSharedPtr>(), argCount);
+        }
+        if (!callee.is<FuncSharedPtr>()) {
+            runtimeError("Can only call functions.");
+            return false;
+        }
+        const auto func = callee.as<FuncSharedPtr>();
+        if (func->arity() != argCount) {
+            runtimeError(std::format("Expected {} arguments but got {}.", func->arity(), argCount));
+            return false;
+        }
+        if (frames.size() == frames_max) {
+            runtimeError("Stack overflow.");
+            return false;
+        }
+        auto& body = *func->getBody();
+        if (!body.isCompiled() && !std::exchange(body.compileBody, nullptr)(body.chunk)) {
+            runtimeError(std::format("Could not compile function {}.", func->getFuncName()));
+            return false;
+        }
+        frames.emplace_back(CallFrame{
+            .closure = func,
+            .chunk = &body.chunk,
+            .instructionPtr = 0,
+            .slots = stack.size() - argCount - 1
+        });
+        return true;
+    }
+
+    // natives don't get a frame, they read their arguments right off the stack and the result replaces the call
+    bool SpicyVM::callNative(const BuiltinFunc& native, uint8_t argCount) {
+        if (native.arity() != argCount) {
+            runtimeError(std::format("Expected {} arguments but got {}.", native.arity(), argCount));
+            return false;
+        }
+        const auto args = std::span<const SpicyObj>(stack).last(argCount);
+        auto result = SpicyObj{};
+        try {
+            result = native.run(args);
+        } catch (const RuntimeError& err) {
+            runtimeError(err.what());
+            return false;
+        }
+        stack.resize(stack.size() - argCount - 1);
+        push(std::move(result));
+        return true;
+    }
+
+    std::shared_ptr<Upvalue> SpicyVM::captureUpvalue(size_t slot) {
+        auto iter = open_upvalues.rbegin();
+        for (; iter != open_upvalues.rend() && (*iter)->slot >= slot; ++iter) {
+            if ((*iter)->slot == slot) return *iter;
+        }
+        auto upvalue = std::make_shared<Upvalue>(Upvalue{ .slot = slot });
+        open_upvalues.insert(iter.base(), upvalue);
+        return upvalue;
+    }
+
+    SpicyObj& SpicyVM::upvalueRef(const std::shared_ptr<Upvalue>& upvalue) {
+        return upvalue->isOpen ? stack[upvalue->slot] : upvalue->closed;
     }
-    
+
+    void SpicyVM::closeUpvalues(size_t lastSlot) {
+        while (!open_upvalues.empty() && open_upvalues.back()->slot >= lastSlot) {
+            auto& upvalue = open_upvalues.back();
+            upvalue->closed = stack[upvalue->slot];
+            upvalue->isOpen = false;
+            open_upvalues.pop_back();
+        }
+    }
+
     void SpicyVM::printStack() {
         std::cout << "Stack: " << '\t';
-        for (const auto& value : stack[current_stack]) {
+        for (const auto& value : stack) {
             std::cout << std::format("[ {} ]", getObjString(value));
         }
         std::cout << '\n';
     }
-    
-    void SpicyVM::runtimeError(const std::string& msg, const Chunk& chunk) {
-        error(chunk.getLine(program_counter - 1), msg);
+
+    void SpicyVM::runtimeError(const std::string& msg) {
+        const auto& frame = frames.back();
+        error(frame.chunk->getLine(frame.instructionPtr - 1), msg);
         reset(false);
     }
 }
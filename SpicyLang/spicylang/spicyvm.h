@@ -2,6 +2,7 @@
 #ifndef H_SPICYVM
 #define H_SPICYVM
 
+#include <span>
 #include <vector>
 #include <tuple>
 #include <unordered_map>
@@ -12,31 +13,43 @@ namespace spicy {
 
 template<typename T>
 using Stack = std::vector<T>;
-    
+
 class SpicyVM {
-    Stack<Stack<SpicyObj>> stack;
-    std::unordered_map<std::string, SpicyObj> globals;
-    
+    static constexpr auto frames_max = 1024ull;
+
+    Stack<SpicyObj> stack;
+    Stack<CallFrame> frames;
+    std::vector<std::shared_ptr<Upvalue>> open_upvalues; // sorted by stack slot
+    std::unordered_map<StringSharedPtr, SpicyObj, RefHash> globals;   // keyed by interned name
+
     bool trace_execution;
     bool is_repl;
-    unsigned long current_stack = 0l;
-    unsigned long program_counter = 0l;
+    bool prelude_loaded = false;
 public:
     explicit SpicyVM(bool trace_execution, bool is_repl);
     void disassemble(const Chunk& chunk);
     void execute(const Chunk& chunk);
 private:
+    void runChunk(const Chunk& chunk);
+    void run();
     void reset(bool is_repl);
-    [[nodiscard]] uint8_t readByte(const Chunk& chunk);
-    [[nodiscard]] uint16_t readShort(const Chunk& chunk);
-    
+    [[nodiscard]] uint8_t readByte();
+    [[nodiscard]] uint16_t readShort();
+    [[nodiscard]] const SpicyObj& readConstant();
+
     void push(SpicyObj value);
     SpicyObj pop();
     SpicyObj& peek(int distance);
-    
+
+    [[nodiscard]] bool callValue(const SpicyObj& callee, uint8_t argCount);
+    [[nodiscard]] bool callNative(const BuiltinFunc& native, uint8_t argCount);
+    [[nodiscard]] std::shared_ptr<Upvalue> captureUpvalue(size_t slot);
+    [[nodiscard]] SpicyObj& upvalueRef(const std::shared_ptr<Upvalue>& upvalue);
+    void closeUpvalues(size_t lastSlot);
+
     void printStack();
-    void runtimeError(const std::string& msg, const Chunk& chunk);
-    
+    void runtimeError(const std::string& msg);
+
 };
 
 
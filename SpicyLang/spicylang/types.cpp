@@ -1,5 +1,9 @@
 #include "types.h"
 
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
 namespace spicy {
 // Token
 Token::Token() : type(TokenType::ERROR), lexeme(""), literal(std::nullopt), line(-1) {}
@@ -66,6 +70,131 @@ const std::string Token::toString() const noexcept {
     }
 }
 
+// StringObj
+namespace {
+// the views point into the interned objects themselves, which take themselves out when they die.
+// Never destroyed, strings held by statics can outlive any other static
+auto& internedStrings() {
+    static auto* table = new std::unordered_map<std::string_view, StringObj*>();
+    return *table;
+}
+}
+
+StringObj::StringObj(std::string str) : SpicyHeapObj(SpicyType::String), m_str(std::move(str)), m_length(m_str.size()) {}
+
+StringObj::StringObj(Ref<StringObj> left, Ref<StringObj> right)
+    : SpicyHeapObj(SpicyType::String), m_left(std::move(left)), m_right(std::move(right)),
+      m_length(m_left->m_length + m_right->m_length) {}
+
+StringObj::~StringObj() {
+    if (m_interned)
+        internedStrings().erase(m_str);
+    releaseHalves();
+}
+
+Ref<StringObj> StringObj::concat(const Ref<StringObj>& lhs, const Ref<StringObj>& rhs) {
+    if (lhs->m_length + rhs->m_length < minRopeLength)
+        return makeRef<StringObj>(lhs->str() + rhs->str());
+    return Ref<StringObj>(new StringObj(lhs, rhs));
+}
+
+// a rope made by a loop is as deep as the loop was long, it's walked with a stack of its own rather than recursively
+void StringObj::flatten() const {
+    auto flat = std::string{};
+    flat.reserve(m_length);
+    auto pending = std::vector<const StringObj*>{ m_right.get(), m_left.get() };
+    while (!pending.empty()) {
+        const auto* node = pending.back();
+        pending.pop_back();
+        if (node->m_left != nullptr) {
+            pending.push_back(node->m_right.get());
+            pending.push_back(node->m_left.get());
+        } else {
+            flat += node->m_str;
+        }
+    }
+    m_str = std::move(flat);
+    releaseHalves();
+}
+
+// same as above, halves only this rope holds are taken apart here before they go, instead of in their own destructor
+void StringObj::releaseHalves() const {
+    auto pending = std::vector<Ref<StringObj>>{};
+    pending.push_back(std::move(m_left));
+    pending.push_back(std::move(m_right));
+    while (!pending.empty()) {
+        auto node = std::move(pending.back());
+        pending.pop_back();
+        if (node != nullptr && node->isUnique() && node->m_left != nullptr) {
+            pending.push_back(std::move(node->m_left));
+            pending.push_back(std::move(node->m_right));
+        }
+    }
+}
+
+Ref<StringObj> StringObj::intern(std::string_view str) {
+    auto& table = internedStrings();
+    if (const auto found = table.find(str); found != table.end())
+        return Ref<StringObj>(found->second);
+    auto* obj = new StringObj(std::string(str));
+    obj->m_interned = true;
+    table.emplace(obj->m_str, obj);
+    return Ref<StringObj>(obj);
+}
+
+size_t StringObj::hash() const {
+    if (!m_hashed) {
+        m_hash = std::hash<std::string>{}(str());
+        m_hashed = true;
+    }
+    return m_hash;
+}
+
+bool operator==(const StringObj &lhs, const StringObj &rhs) {
+    if (&lhs == &rhs) return true;
+    if (lhs.m_interned && rhs.m_interned) return false;
+    if (lhs.m_length != rhs.m_length) return false;
+    if (lhs.m_hashed && rhs.m_hashed && lhs.m_hash != rhs.m_hash) return false;
+    return lhs.str() == rhs.str();
+}
+
+// SpicyObj
+SpicyObj::SpicyObj(std::string str) {
+    const auto* obj = new StringObj(std::move(str));
+    SpicyHeapObj::retain(obj);
+    m_bits = box(obj);
+}
+
+SpicyObj::SpicyObj(int64_t number) {
+    if (number >= minInlineInt && number <= maxInlineInt) {
+        m_bits = intTag | (static_cast<uint64_t>(number) & intPayload);
+        return;
+    }
+    const auto* obj = new IntObj(number);
+    SpicyHeapObj::retain(obj);
+    m_bits = box(obj);
+}
+
+bool operator==(const SpicyObj &lhs, const SpicyObj &rhs) {
+    if (lhs.is<double>() && rhs.is<double>())
+        return lhs.as<double>() == rhs.as<double>();
+    if (lhs.is<int64_t>() && rhs.is<int64_t>())
+        return lhs.as<int64_t>() == rhs.as<int64_t>();
+    if (lhs.is<int64_t>() && rhs.is<double>())
+        return static_cast<double>(lhs.as<int64_t>()) == rhs.as<double>();
+    if (lhs.is<double>() && rhs.is<int64_t>())
+        return lhs.as<double>() == static_cast<double>(rhs.as<int64_t>());
+    if (lhs.is<std::string>() && rhs.is<std::string>())
+        return static_cast<const StringObj&>(*lhs.heap()) == static_cast<const StringObj&>(*rhs.heap());
+    return lhs.m_bits == rhs.m_bits;
+}
+
+// MethodIndex
+MethodIndex methodIndex(const std::string& name) {
+    static std::unordered_map<std::string, MethodIndex> indices;
+    return indices.try_emplace(name, static_cast<MethodIndex>(indices.size())).first->second;
+}
+
 // RuntimeError
 RuntimeError::RuntimeError(Token token, const std::string &msg) : m_token(std::move(token)), m_msg(msg) {}
 
@@ -2,10 +2,19 @@
 #ifndef H_SPICYTYPES
 #define H_SPICYTYPES
 
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <optional>
 #include <variant>
 #include <string>
+#include <string_view>
 #include <exception>
+#include <type_traits>
+#include <utility>
+
+#include "spicyutil.h"
 
 namespace spicy {
 
@@ -30,7 +39,274 @@ enum class TokenType {
     ERROR
 };
 
-using TokenLiteral = std::variant<double, std::string>;
+// runtime values are declared here, next to the literals they're made from, so that the ast can hold them too
+enum class SpicyType : uint8_t {
+    Number, Int, Bool, Nil,
+    // the rest live on the heap, integers too when they're too wide to be stored inline
+    String, Func, Builtin, Class, Instance, List
+};
+
+// Base of everything a value can point to. The count is kept in the object so that a value only needs its address,
+// values aren't shared across threads so it's a plain integer.
+class SpicyHeapObj : public util::Uncopyable {
+    mutable uint32_t m_refs = 0;
+    const SpicyType m_type;
+
+public:
+    explicit SpicyHeapObj(SpicyType type) : m_type(type) {}
+
+    [[nodiscard]] SpicyType type() const { return m_type; }
+    // nothing but the caller's reference is keeping it alive
+    [[nodiscard]] bool isUnique() const { return m_refs == 1; }
+
+    static void retain(const SpicyHeapObj* obj) { ++obj->m_refs; }
+    static void release(const SpicyHeapObj* obj) {
+        if (--obj->m_refs == 0)
+            delete obj;
+    }
+};
+
+// An owning handle to a heap object, same idea as a shared_ptr but a single pointer
+template <typename T>
+class Ref {
+    T* m_ptr = nullptr;
+
+    template <typename U> friend class Ref;
+    friend class SpicyObj;
+
+public:
+    using element_type = T;
+
+    Ref() = default;
+    Ref(std::nullptr_t) {}
+    explicit Ref(T* ptr) : m_ptr(ptr) { retain(); }
+    Ref(const Ref& other) : m_ptr(other.m_ptr) { retain(); }
+    Ref(Ref&& other) noexcept : m_ptr(std::exchange(other.m_ptr, nullptr)) {}
+    template <typename U> requires std::is_convertible_v<U*, T*>
+    Ref(Ref<U> other) : m_ptr(std::exchange(other.m_ptr, nullptr)) {}
+    ~Ref() { if (m_ptr != nullptr) SpicyHeapObj::release(m_ptr); }
+
+    Ref& operator=(Ref other) noexcept {
+        std::swap(m_ptr, other.m_ptr);
+        return *this;
+    }
+
+    [[nodiscard]] T* get() const { return m_ptr; }
+    T& operator*() const { return *m_ptr; }
+    T* operator->() const { return m_ptr; }
+    explicit operator bool() const { return m_ptr != nullptr; }
+    void reset() { Ref().swap(*this); }
+    void swap(Ref& other) noexcept { std::swap(m_ptr, other.m_ptr); }
+
+    friend bool operator==(const Ref& lhs, const Ref& rhs) { return lhs.m_ptr == rhs.m_ptr; }
+    friend bool operator==(const Ref& lhs, std::nullptr_t) { return lhs.m_ptr == nullptr; }
+
+private:
+    void retain() const { if (m_ptr != nullptr) SpicyHeapObj::retain(m_ptr); }
+};
+
+template <typename T, typename... Args>
+[[nodiscard]] Ref<T> makeRef(Args&&... args) {
+    return Ref<T>(new T(std::forward<Args>(args)...));
+}
+
+// hashes a Ref by the address it holds, for maps keyed on objects that are unique by construction (interned strings)
+struct RefHash {
+    template <typename T>
+    size_t operator()(const Ref<T>& ref) const { return std::hash<const T*>{}(ref.get()); }
+};
+
+// Strings never change once made, so every value holding one shares the same object.
+// Literals and names are interned, one object per distinct content: two of them are equal only if they're the same
+// object. Strings made at runtime aren't, they're compared by content, skipping it when their hashes already differ.
+// Concatenations past a few dozen characters are ropes, the two halves are only joined the first time the text is
+// looked at, so that building a string piece by piece is linear instead of copying everything at every step.
+class StringObj : public SpicyHeapObj {
+    static constexpr size_t minRopeLength = 64;
+
+    mutable std::string m_str;          // empty until flattened for a rope
+    mutable Ref<StringObj> m_left;      // ropes only
+    mutable Ref<StringObj> m_right;
+    const size_t m_length;
+    mutable size_t m_hash = 0;
+    mutable bool m_hashed = false;
+    bool m_interned = false;
+
+    StringObj(Ref<StringObj> left, Ref<StringObj> right);
+    void flatten() const;
+    void releaseHalves() const;
+
+public:
+    explicit StringObj(std::string str);
+    ~StringObj() override;
+
+    [[nodiscard]] static Ref<StringObj> intern(std::string_view str);
+    [[nodiscard]] static Ref<StringObj> concat(const Ref<StringObj>& lhs, const Ref<StringObj>& rhs);
+
+    [[nodiscard]] const std::string& str() const {
+        if (m_left != nullptr) flatten();
+        return m_str;
+    }
+    [[nodiscard]] size_t length() const { return m_length; }
+    [[nodiscard]] size_t hash() const;
+
+    friend bool operator==(const StringObj& lhs, const StringObj& rhs);
+};
+using StringSharedPtr = Ref<StringObj>;
+
+// an integer that doesn't fit in the payload of a NaN, rare enough that it can afford an allocation
+class IntObj : public SpicyHeapObj {
+    const int64_t m_value;
+
+public:
+    explicit IntObj(int64_t value) : SpicyHeapObj(SpicyType::Int), m_value(value) {}
+
+    [[nodiscard]] int64_t value() const { return m_value; }
+};
+
+class FuncObj;
+using FuncSharedPtr = Ref<FuncObj>;
+
+class BuiltinFunc;
+using BuiltinFuncSharedPtr = Ref<BuiltinFunc>;
+
+class SpicyClass;
+using SpicyClassSharedPtr = Ref<SpicyClass>;
+
+class SpicyInstance;
+using SpicyInstanceSharedPtr = Ref<SpicyInstance>;
+class Shape;
+
+class SpicyList;
+using SpicyListSharedPtr = Ref<SpicyList>;
+
+// which SpicyType each of the types a value can be read as stands for
+template <typename T> struct SpicyTypeOf;
+template <> struct SpicyTypeOf<double> { static constexpr auto type = SpicyType::Number; };
+template <> struct SpicyTypeOf<int64_t> { static constexpr auto type = SpicyType::Int; };
+template <> struct SpicyTypeOf<bool> { static constexpr auto type = SpicyType::Bool; };
+template <> struct SpicyTypeOf<std::nullptr_t> { static constexpr auto type = SpicyType::Nil; };
+template <> struct SpicyTypeOf<std::string> { static constexpr auto type = SpicyType::String; };
+template <> struct SpicyTypeOf<StringSharedPtr> { static constexpr auto type = SpicyType::String; };
+template <> struct SpicyTypeOf<FuncSharedPtr> { static constexpr auto type = SpicyType::Func; };
+template <> struct SpicyTypeOf<BuiltinFuncSharedPtr> { static constexpr auto type = SpicyType::Builtin; };
+template <> struct SpicyTypeOf<SpicyClassSharedPtr> { static constexpr auto type = SpicyType::Class; };
+template <> struct SpicyTypeOf<SpicyInstanceSharedPtr> { static constexpr auto type = SpicyType::Instance; };
+template <> struct SpicyTypeOf<SpicyListSharedPtr> { static constexpr auto type = SpicyType::List; };
+
+/*
+ * A runtime value, NaN-boxed into 64 bits. Numbers are stored as themselves; everything else hides in the payload
+ * of a quiet NaN no arithmetic produces: nil and the booleans as small constants, integers as a 49-bit two's complement
+ * payload behind their own tag bit, heap objects as their address with the sign bit set. Wider integers are boxed in
+ * an IntObj, which is invisible to is<int64_t>() and as<int64_t>(). Copying a number, a bool or nil is copying a word,
+ * copying an object bumps its count.
+ * Read them with is<T>() and as<T>(), T being one of the types listed in SpicyTypeOf.
+ */
+class SpicyObj {
+    static constexpr uint64_t signBit = 0x8000000000000000;
+    static constexpr uint64_t quietNan = 0x7ffc000000000000;
+    static constexpr uint64_t nilBits = quietNan | 1;
+    static constexpr uint64_t falseBits = quietNan | 2;
+    static constexpr uint64_t trueBits = quietNan | 3;
+    static constexpr uint64_t intTag = quietNan | (uint64_t{1} << 49);
+    static constexpr uint64_t intPayload = (uint64_t{1} << 49) - 1;
+    static constexpr int64_t maxInlineInt = (int64_t{1} << 48) - 1;
+    static constexpr int64_t minInlineInt = -(int64_t{1} << 48);
+
+    uint64_t m_bits = nilBits;
+
+    [[nodiscard]] bool isHeap() const { return (m_bits & (signBit | quietNan)) == (signBit | quietNan); }
+    [[nodiscard]] bool isInlineInt() const { return (m_bits & (signBit | intTag)) == intTag; }
+    [[nodiscard]] SpicyHeapObj* heap() const {
+        return reinterpret_cast<SpicyHeapObj*>(static_cast<uintptr_t>(m_bits & ~(signBit | quietNan)));
+    }
+    static uint64_t box(const SpicyHeapObj* obj) {
+        return signBit | quietNan | static_cast<uint64_t>(reinterpret_cast<uintptr_t>(obj));
+    }
+
+public:
+    SpicyObj() = default;
+    SpicyObj(std::nullptr_t) {}
+    SpicyObj(double number) : m_bits(std::bit_cast<uint64_t>(number)) {}
+    SpicyObj(int64_t number);
+    SpicyObj(bool boolean) : m_bits(boolean ? trueBits : falseBits) {}
+    SpicyObj(std::string str);
+    SpicyObj(const char* str) : SpicyObj(std::string(str)) {}
+    // no silent conversion from the other integer types, they'd pick bool or be ambiguous
+    template <typename T> requires std::is_integral_v<T> && (!std::is_same_v<T, bool>) && (!std::is_same_v<T, int64_t>)
+    SpicyObj(T) = delete;
+    template <typename T>
+    SpicyObj(Ref<T> ref) {
+        if (ref.m_ptr != nullptr)
+            m_bits = box(std::exchange(ref.m_ptr, nullptr));
+    }
+
+    SpicyObj(const SpicyObj& other) : m_bits(other.m_bits) {
+        if (isHeap()) SpicyHeapObj::retain(heap());
+    }
+    SpicyObj(SpicyObj&& other) noexcept : m_bits(std::exchange(other.m_bits, nilBits)) {}
+    ~SpicyObj() {
+        if (isHeap()) SpicyHeapObj::release(heap());
+    }
+
+    SpicyObj& operator=(SpicyObj other) noexcept {
+        std::swap(m_bits, other.m_bits);
+        return *this;
+    }
+
+    // what std::variant's comparison did: numbers and strings by value, objects by identity.
+    // An integer and a double holding the same number are equal.
+    friend bool operator==(const SpicyObj& lhs, const SpicyObj& rhs);
+
+    [[nodiscard]] SpicyType type() const {
+        if ((m_bits & quietNan) != quietNan) return SpicyType::Number;
+        if (isHeap()) return heap()->type();
+        if (isInlineInt()) return SpicyType::Int;
+        return m_bits == nilBits ? SpicyType::Nil : SpicyType::Bool;
+    }
+
+    template <typename T>
+    [[nodiscard]] bool is() const {
+        if constexpr (std::is_same_v<T, double>)
+            return (m_bits & quietNan) != quietNan;
+        else if constexpr (std::is_same_v<T, int64_t>)
+            return isInlineInt() || (isHeap() && heap()->type() == SpicyType::Int);
+        else if constexpr (std::is_same_v<T, bool>)
+            return (m_bits | 1) == trueBits;
+        else if constexpr (std::is_same_v<T, std::nullptr_t>)
+            return m_bits == nilBits;
+        else
+            return isHeap() && heap()->type() == SpicyTypeOf<T>::type;
+    }
+
+    // the value as a T, which it has to be
+    template <typename T>
+    [[nodiscard]] decltype(auto) as() const {
+        if constexpr (std::is_same_v<T, double>)
+            return std::bit_cast<double>(m_bits);
+        else if constexpr (std::is_same_v<T, int64_t>)
+            return isInlineInt() ? static_cast<int64_t>(m_bits << 15) >> 15 : static_cast<const IntObj*>(heap())->value();
+        else if constexpr (std::is_same_v<T, bool>)
+            return m_bits == trueBits;
+        else if constexpr (std::is_same_v<T, std::nullptr_t>)
+            return nullptr;
+        else if constexpr (std::is_same_v<T, std::string>)
+            return static_cast<const StringObj*>(heap())->str();
+        else
+            return T(static_cast<typename T::element_type*>(heap()));
+    }
+};
+
+static_assert(sizeof(SpicyObj) == sizeof(uint64_t), "SpicyObj has to stay a single word");
+
+using OptSpicyObj = std::optional<SpicyObj>;
+
+// Method names are numbered densely in the order they're first seen, the same name always getting the same index,
+// so that a class can keep its methods in a plain table indexed by them.
+using MethodIndex = uint32_t;
+MethodIndex methodIndex(const std::string& name);
+
+using TokenLiteral = std::variant<double, int64_t, std::string>;
 using OptTokenLiteral = std::optional<TokenLiteral>;
 struct Token {
     TokenType type;
@@ -34,6 +34,20 @@ size_t spicy::Chunk::disassembleInvokeInstruction(const std::string& name, size_
     return offset + invoke_instruction_size;
 }
 
+size_t spicy::Chunk::disassembleClosureInstruction(const std::string& name, size_t offset) const noexcept {
+    const auto constant = bytecode[offset + 1];
+    const auto upvalueCount = bytecode[offset + 2];
+    std::cout << std::format("{} {:4d} '{}'\n", name, constant, getObjString(constants[constant]));
+    auto current = offset + 3;
+    for (auto i = 0; i < upvalueCount; ++i) {
+        const auto isLocal = bytecode[current];
+        const auto index = bytecode[current + 1];
+        std::cout << std::format("{:04d}    |                     {} {}\n", current, isLocal ? "local" : "upvalue", index);
+        current += 2;
+    }
+    return current;
+}
+
 void spicy::Chunk::appendByte(uint8_t byte, int line) noexcept {
     bytecode.emplace_back(byte);
     // Do not add a new line if the previous line is the same (multiple intructions per line)
@@ -74,6 +88,26 @@ size_t spicy::Chunk::disassembleInstruction(size_t offset) const noexcept {
         return disassembleByteInstruction("OP_GET_LOCAL", offset);
     case OpCode::OP_SET_LOCAL:
         return disassembleByteInstruction("OP_SET_LOCAL", offset);
+    case OpCode::OP_GET_UPVALUE:
+        return disassembleByteInstruction("OP_GET_UPVALUE", offset);
+    case OpCode::OP_SET_UPVALUE:
+        return disassembleByteInstruction("OP_SET_UPVALUE", offset);
+    case OpCode::OP_CALL:
+        return disassembleByteInstruction("OP_CALL", offset);
+    case OpCode::OP_CLOSURE:
+        return disassembleClosureInstruction("OP_CLOSURE", offset);
+    case OpCode::OP_CLOSE_UPVALUE:
+        return disassembleSimpleInstruction("OP_CLOSE_UPVALUE", offset);
+    case OpCode::OP_LIST:
+        return disassembleSimpleInstruction("OP_LIST", offset);
+    case OpCode::OP_APPEND:
+        return disassembleSimpleInstruction("OP_APPEND", offset);
+    case OpCode::OP_PREPEND:
+        return disassembleSimpleInstruction("OP_PREPEND", offset);
+    case OpCode::OP_GET_INDEX:
+        return disassembleSimpleInstruction("OP_GET_INDEX", offset);
+    case OpCode::OP_SET_INDEX:
+        return disassembleSimpleInstruction("OP_SET_INDEX", offset);
     case OpCode::OP_NIL:
         return disassembleSimpleInstruction("OP_NIL", offset);
     case OpCode::OP_TRUE:
@@ -144,10 +178,10 @@ int spicy::Chunk::getBytecodeCount() const noexcept {
     return bytecode.size();
 }
 
-std::vector<uint8_t> spicy::Chunk::getBytecode() const noexcept {
+const std::vector<uint8_t>& spicy::Chunk::getBytecode() const noexcept {
     return bytecode;
 }
 
-std::vector<spicy::SpicyObj> spicy::Chunk::getConstants() const noexcept {
+const std::vector<spicy::SpicyObj>& spicy::Chunk::getConstants() const noexcept {
     return constants;
 }
@@ -2,6 +2,7 @@
 #ifndef H_VMTYPES
 #define H_VMTYPES
 
+#include <functional>
 #include <vector>
 #include <utility>
 #include <variant>
@@ -36,6 +37,7 @@ class Chunk {
     [[nodiscard]] size_t disassembleByteInstruction(const std::string& name, size_t offset) const noexcept;
     [[nodiscard]] size_t disassembleJumpInstruction(const std::string& name, int sign, size_t offset) const noexcept;
     [[nodiscard]] size_t disassembleInvokeInstruction(const std::string& name, size_t offset) const noexcept;
+    [[nodiscard]] size_t disassembleClosureInstruction(const std::string& name, size_t offset) const noexcept;
     
 public:
     enum class OpCode {
@@ -75,7 +77,12 @@ public:
         OP_RETURN,
         OP_CLASS,
         OP_INHERIT,
-        OP_METHOD
+        OP_METHOD,
+        OP_LIST,
+        OP_APPEND,
+        OP_PREPEND,
+        OP_GET_INDEX,
+        OP_SET_INDEX
     };
     
     void appendByte(uint8_t byte, int line) noexcept;
@@ -86,8 +93,18 @@ public:
 
     [[nodiscard]] uint32_t getLine(size_t offset) const noexcept;
     [[nodiscard]] int getBytecodeCount() const noexcept;
-    [[nodiscard]] std::vector<uint8_t> getBytecode() const noexcept;
-    [[nodiscard]] std::vector<SpicyObj> getConstants() const noexcept;
+    [[nodiscard]] const std::vector<uint8_t>& getBytecode() const noexcept;
+    [[nodiscard]] const std::vector<SpicyObj>& getConstants() const noexcept;
+};
+
+// Bytecode of a function, shared by every closure made from the same declaration.
+// Bodies are compiled the first time one of those closures is called, until then compileBody holds
+// everything the compiler needs to do it. It returns false if the body had compile errors.
+struct FuncBody {
+    Chunk chunk = {};
+    std::function<bool(Chunk&)> compileBody = nullptr;
+
+    [[nodiscard]] bool isCompiled() const noexcept { return compileBody == nullptr; }
 };
 
 enum class FuncType {
@@ -102,10 +119,19 @@ struct Func {
     std::string name = "";
 };
 
-struct CallFrame {
-    Func function;
-    uint8_t instructionPtr;
+// A captured variable, it points at a slot of the vm stack while the variable is still alive on it (open)
+// and owns the value once the variable goes out of scope (closed)
+struct Upvalue {
+    size_t slot = 0;
+    bool isOpen = true;
+    SpicyObj closed = nullptr;
+};
 
+struct CallFrame {
+    FuncSharedPtr closure;  // nullptr for the top-level script
+    const Chunk* chunk;
+    size_t instructionPtr;
+    size_t slots;           // index of the frame's first stack slot, slot 0 holds the callee
 };
 
 }